@@ -0,0 +1,213 @@
+#include "aobscanner.hpp"
+#include "blockreader.hpp"
+#include "kernels.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    /**
+     * \brief How common a byte is in code and data, higher is more common. Bytes that aren't listed are rare.
+     */
+    int commonness(unsigned char byte)
+    {
+        static const unsigned char common[] = {0x00, 0xff, 0xcc, 0x48, 0x8b, 0x89, 0x01, 0x0f, 0x90, 0x24,
+                                               0x44, 0x4c, 0xe8, 0x83, 0x8d, 0x20, 0x08, 0x10, 0x02, 0x04};
+        const int count = sizeof(common);
+
+        for (int i = 0; i < count; i++)
+        {
+            if (common[i] == byte)
+            {
+                return count - i;
+            }
+        }
+
+        return 0;
+    }
+
+    int hexDigit(char ch)
+    {
+        if (std::isdigit(static_cast<unsigned char>(ch)))
+        {
+            return ch - '0';
+        }
+        ch = std::tolower(static_cast<unsigned char>(ch));
+        return (ch >= 'a' && ch <= 'f') ? ch - 'a' + 10 : -1;
+    }
+}
+
+AobPattern::AobPattern(const std::string& text)
+    : m_text(text)
+    , m_anchor(0)
+    , m_last(0)
+{
+    if (parse(text))
+    {
+        plan();
+    }
+}
+
+/**
+ * \brief Parse the pattern text into bytes and mask. Leaves both empty if the text isn't a valid pattern or has no
+ * fixed byte.
+ */
+bool AobPattern::parse(const std::string& text)
+{
+    std::istringstream tokens(text);
+    std::string token;
+
+    while (tokens >> token)
+    {
+        if (token == "?" || token == "??")
+        {
+            m_bytes.push_back(0);
+            m_mask.push_back(0);
+            continue;
+        }
+
+        for (size_t i = 0; i < token.size(); i += 2)
+        {
+            int high = (i + 1 < token.size()) ? hexDigit(token[i]) : -1;
+            int low = (i + 1 < token.size()) ? hexDigit(token[i+1]) : -1;
+
+            if (token.compare(i, 2, "??") == 0)
+            {
+                m_bytes.push_back(0);
+                m_mask.push_back(0);
+            }
+            else if (high < 0 || low < 0)
+            {
+                m_bytes.clear();
+                m_mask.clear();
+                return false;
+            }
+            else
+            {
+                m_bytes.push_back(static_cast<char>(high << 4 | low));
+                m_mask.push_back(static_cast<char>(0xff));
+            }
+        }
+    }
+
+    if (std::count(m_mask.begin(), m_mask.end(), 0) == static_cast<long>(m_mask.size()))
+    {
+        m_bytes.clear();
+        m_mask.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Pick the rarest fixed byte as anchor and build the skip table. The skip of a byte is the distance from the
+ * end of the pattern to its last position that byte or a wildcard could take, not counting the last position.
+ */
+void AobPattern::plan()
+{
+    size_t size = m_bytes.size();
+
+    for (size_t i = 0; i < size; i++)
+    {
+        if (m_mask[i] == 0)
+        {
+            continue;
+        }
+        if (m_mask[m_anchor] == 0 || commonness(m_bytes[i]) < commonness(m_bytes[m_anchor]))
+        {
+            m_anchor = i;
+        }
+        m_last = i;
+    }
+
+    m_skip.assign(256, size);
+    for (size_t i = 0; i + 1 < size; i++)
+    {
+        if (m_mask[i] == 0)
+        {
+            std::fill(m_skip.begin(), m_skip.end(), size - 1 - i);
+        }
+        else
+        {
+            m_skip[static_cast<unsigned char>(m_bytes[i])] = size - 1 - i;
+        }
+    }
+}
+
+bool AobPattern::isValid() const
+{
+    return !m_bytes.empty();
+}
+
+/**
+ * \brief View of the compiled pattern for the pattern kernels. Only valid while the pattern exists.
+ */
+Kernels::PatternArgs AobPattern::args() const
+{
+    return {m_bytes.data(), m_mask.data(), m_bytes.size(), m_anchor, m_last, m_skip.data()};
+}
+
+AobScanner::AobScanner(std::shared_ptr<ScanSession> session, ThreadPool& pool)
+    : m_session(session)
+    , m_pool(pool)
+{}
+
+/**
+ * \brief Keep the offsets where pattern starts. Read the live pages of all blocks batch by batch and filter each
+ * batch in parallel. Patterns don't compare with previous values, so nothing is stored. Blocks without matches are
+ * dropped at the end.
+ */
+void AobScanner::updateScan(const AobPattern& pattern)
+{
+    Kernels::PatternFilter filter = Kernels::patternFilter();
+    Kernels::PatternArgs args = pattern.args();
+    BlockReader reader(pHandle(), memblocks(), args.size - 1);
+
+    for (auto& mb : memblocks())
+    {
+        mb.matches() = 0;
+    }
+
+    while (reader.next())
+    {
+        std::vector<ScanChunk> chunks = reader.chunks();
+        std::vector<std::vector<size_t>> workerMatches(m_pool.threadCount(),
+                                                       std::vector<size_t>(reader.blocks().size(), 0));
+
+        m_pool.run(chunks.size(), [&](size_t task, int worker)
+        {
+            const ScanChunk& chunk = chunks[task];
+            MemBlock& mb = *reader.blocks()[chunk.block];
+
+            workerMatches[worker][chunk.block] += filter(chunk.data, mb.searchMask().data(), chunk.begin, chunk.end,
+                                                         chunk.limit, args);
+        });
+
+        for (size_t i = 0; i < reader.blocks().size(); i++)
+        {
+            for (auto& matches : workerMatches)
+            {
+                reader.blocks()[i]->matches() += matches[i];
+            }
+        }
+    }
+
+    MemBlock::removeDead(memblocks());
+    m_session->isScanned() = true;
+}
+
+std::vector<char> AobScanner::readBytes(uintptr_t addr, size_t size)
+{
+    std::vector<char> bytes(size, 0);
+
+    if (Process::read(pHandle(), reinterpret_cast<void*>(addr), bytes.data(), size) != size)
+    {
+        std::cout << "reading failed\r\n";
+    }
+
+    return bytes;
+}
\ No newline at end of file
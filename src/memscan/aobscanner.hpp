@@ -0,0 +1,66 @@
+#pragma once
+#include "blockreader.hpp"
+#include "kernels.hpp"
+#include "memblock.hpp"
+#include "process.hpp"
+#include "scansession.hpp"
+#include "threadpool.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Array of bytes pattern like "48 8B ?? ?? 00 00 89", compiled once and reused for every rescan. Bytes are
+ * two hex digits, "?" or "??" is a wildcard, spaces are optional.
+ *
+ * Compiling picks the rarest fixed byte as the anchor the SIMD kernels look for, and builds the skip table of the
+ * scalar kernel.
+ * \param text Pattern text
+ */
+class AobPattern
+{
+    public:
+        AobPattern(const std::string& text);
+
+        bool isValid() const;
+        Kernels::PatternArgs args() const;
+
+        const std::string&       text()   const { return m_text; }
+        const std::vector<char>& bytes()  const { return m_bytes; }
+        const std::vector<char>& mask()   const { return m_mask; }
+        const size_t&            anchor() const { return m_anchor; }
+
+    private:
+        std::string m_text;
+        std::vector<char> m_bytes;
+        std::vector<char> m_mask;
+        size_t m_anchor;
+        size_t m_last;
+        std::vector<size_t> m_skip;
+
+        bool parse(const std::string& text);
+        void plan();
+};
+
+/**
+ * \brief Byte pattern scanner
+ * \param session Scan session, shared with the Scanner
+ * \param pool Thread pool used for filtering
+ */
+class AobScanner
+{
+    public:
+        AobScanner(std::shared_ptr<ScanSession> session, ThreadPool& pool);
+
+        void updateScan(const AobPattern& pattern);
+        std::vector<char> readBytes(uintptr_t addr, size_t size);
+
+        const ProcessHandle&         pHandle()   const { return m_session->pHandle(); }
+              std::vector<MemBlock>& memblocks()       { return m_session->memblocks(); }
+        const std::vector<MemBlock>& memblocks() const { return m_session->memblocks(); }
+
+    private:
+        std::shared_ptr<ScanSession> m_session;
+        ThreadPool& m_pool;
+};
\ No newline at end of file
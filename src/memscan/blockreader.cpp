@@ -0,0 +1,345 @@
+#include "blockreader.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+BlockReader::BlockReader(ProcessHandle pHandle, std::vector<MemBlock>& memblocks, size_t overlap)
+    : m_pHandle(pHandle)
+    , m_memblocks(memblocks)
+    , m_overlap(overlap)
+    , m_current(bufferCount)
+    , m_readDone(false)
+    , m_stop(false)
+{
+    for (size_t block = 0; block < m_memblocks.size(); block++)
+    {
+        findSegments(block);
+    }
+    for (size_t i = 0; i < bufferCount; i++)
+    {
+        m_free.push_back(i);
+    }
+    m_thread = std::thread(&BlockReader::readLoop, this);
+}
+
+BlockReader::~BlockReader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+}
+
+/**
+ * \brief Check if any value starting on a page of a block is still in search
+ */
+bool BlockReader::isPageLive(const MemBlock& mb, size_t page) const
+{
+    size_t firstByte = page * pageSize / mb.stride() / 8;
+    size_t lastByte = std::min((page+1) * pageSize / mb.stride() / 8, mb.searchMask().size());
+    const char* mask = mb.searchMask().data();
+
+    for (size_t i = firstByte; i < lastByte; i++)
+    {
+        if (mask[i] != 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * \brief Append the live page runs of a block to m_segments. Runs are split at batchBytes so that every segment fits
+ * into one read buffer no matter how large the region is. Sparse blocks have no segments.
+ */
+void BlockReader::findSegments(size_t block)
+{
+    const MemBlock& mb = m_memblocks[block];
+    size_t pages = (mb.size() + pageSize - 1) / pageSize;
+    size_t first = m_segments.size();
+
+    if (mb.isSparse())
+    {
+        return;
+    }
+
+    for (size_t page = 0; page < pages; page++)
+    {
+        if (!isPageLive(mb, page))
+        {
+            continue;
+        }
+
+        size_t begin = page * pageSize;
+        size_t end = std::min(begin + pageSize, mb.size());
+
+        if (m_segments.size() > first && begin - m_segments.back().end <= segmentGap
+            && end - m_segments.back().begin <= batchBytes)
+        {
+            m_segments.back().end = end;
+        }
+        else
+        {
+            m_segments.push_back({block, begin, end, 0, 0});
+        }
+    }
+
+    for (size_t i = first; i < m_segments.size(); i++)
+    {
+        size_t nextBegin = (i+1 < m_segments.size()) ? m_segments[i+1].begin : mb.size();
+
+        m_segments[i].readEnd = std::min(m_segments[i].end + m_overlap, mb.size());
+        m_segments[i].storeEnd = std::min(m_segments[i].readEnd, nextBegin);
+    }
+}
+
+/**
+ * \brief Fill a batch with the segments starting at nextSegment, up to batchBytes, and read them
+ */
+void BlockReader::fillBatch(ReadBatch& batch, size_t& nextSegment)
+{
+    size_t batchSize = 0;
+
+    batch.blocks.clear();
+    batch.segments.clear();
+    batch.requests.clear();
+
+    for (; nextSegment < m_segments.size(); nextSegment++)
+    {
+        ReadSegment segment = m_segments[nextSegment];
+        MemBlock* mb = &m_memblocks[segment.block];
+        size_t readSize = segment.readEnd - segment.begin;
+
+        if (!batch.segments.empty() && batchSize + readSize > batchBytes)
+        {
+            break;
+        }
+        if (batch.blocks.empty() || batch.blocks.back() != mb)
+        {
+            batch.blocks.push_back(mb);
+        }
+        segment.block = batch.blocks.size()-1;
+        batch.segments.push_back(segment);
+        batch.requests.push_back({mb->addr() + segment.begin, nullptr, readSize, 0});
+        batchSize += readSize;
+    }
+
+    batch.staging.resize(batchSize);
+    batchSize = 0;
+    for (auto& req : batch.requests)
+    {
+        req.buffer = batch.staging.data() + batchSize;
+        batchSize += req.size;
+    }
+    Process::readBatch(m_pHandle, batch.requests);
+}
+
+/**
+ * \brief Reader thread. Fills free batches until all segments have been read or the reader is destroyed.
+ */
+void BlockReader::readLoop()
+{
+    size_t nextSegment = 0;
+
+    while (nextSegment < m_segments.size())
+    {
+        size_t batch;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stop || !m_free.empty(); });
+            if (m_stop)
+            {
+                return;
+            }
+            batch = m_free.front();
+            m_free.pop_front();
+        }
+
+        fillBatch(m_batches[batch], nextSegment);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_filled.push_back(batch);
+        }
+        m_wake.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_readDone = true;
+    }
+    m_wake.notify_all();
+}
+
+/**
+ * \brief Values that start in a segment but reach past the bytes that could be read are removed from search
+ */
+void BlockReader::dropUnread(const ReadSegment& segment, const ReadRequest& read)
+{
+    MemBlock& mb = *blocks()[segment.block];
+    size_t limit = segment.begin + read.bytesRead;
+    size_t firstUnread = (limit + 1 >= segment.begin + mb.dataSize()) ? limit + 1 - mb.dataSize() : segment.begin;
+    size_t firstIndex = (firstUnread + mb.stride() - 1) / mb.stride();
+    size_t lastIndex = std::min((segment.end + mb.stride() - 1) / mb.stride(), mb.elementCount(mb.size()));
+
+    if (firstIndex < lastIndex)
+    {
+        mb.fillSearch(firstIndex, lastIndex, false);
+    }
+}
+
+/**
+ * \brief Hand the current batch back to the reader thread and wait for the next one
+ * \return False once all segments have been read
+ */
+bool BlockReader::next()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        if (m_current != bufferCount)
+        {
+            m_free.push_back(m_current);
+            m_current = bufferCount;
+            m_wake.notify_all();
+        }
+        m_wake.wait(lock, [this] { return m_readDone || !m_filled.empty(); });
+        if (m_filled.empty())
+        {
+            return false;
+        }
+        m_current = m_filled.front();
+        m_filled.pop_front();
+    }
+
+    const ReadBatch& batch = m_batches[m_current];
+    for (size_t i = 0; i < batch.segments.size(); i++)
+    {
+        if (batch.requests[i].bytesRead < batch.requests[i].size)
+        {
+            dropUnread(batch.segments[i], batch.requests[i]);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * \brief Split the segments of the current batch into chunks of at most chunkBytes, for parallel filtering
+ */
+std::vector<ScanChunk> BlockReader::chunks() const
+{
+    const ReadBatch& batch = m_batches[m_current];
+    std::vector<ScanChunk> chunks;
+
+    for (size_t i = 0; i < batch.segments.size(); i++)
+    {
+        const ReadSegment& segment = batch.segments[i];
+        size_t limit = segment.begin + batch.requests[i].bytesRead;
+        size_t end = std::min(segment.end, limit);
+
+        for (size_t begin = segment.begin; begin < end; begin += chunkBytes)
+        {
+            size_t chunkEnd = std::min(begin + chunkBytes, end);
+            chunks.push_back({segment.block,
+                              batch.requests[i].buffer + (begin - segment.begin),
+                              begin,
+                              chunkEnd,
+                              chunkEnd == end ? std::min(segment.storeEnd, limit) : chunkEnd,
+                              limit});
+        }
+    }
+
+    return chunks;
+}
+
+/**
+ * \brief Copy the new values of a chunk over the previous values of its block
+ */
+void BlockReader::store(const ScanChunk& chunk)
+{
+    std::memcpy(blocks()[chunk.block]->buffer().data() + chunk.begin, chunk.data, chunk.storeEnd - chunk.begin);
+}
+
+/**
+ * \brief Read the survivors of all sparse blocks and pass them to filter span by span. Survivors that lie close 
+ * together are coalesced into one read span, and all spans are read with vectored reads of at most batchBytes. 
+ * Survivors that filter set to address 0 are erased afterwards.
+ */
+void BlockReader::readSparse(ProcessHandle pHandle, std::vector<MemBlock>& memblocks, const SpanFilter& filter)
+{
+    std::vector<SparseSpan> spans;
+    size_t first = 0;
+
+    for (size_t i = 0; i < memblocks.size(); i++)
+    {
+        MemBlock& mb = memblocks[i];
+        std::vector<SparseMatch>& matches = mb.sparseMatches();
+
+        if (!mb.isSparse())
+        {
+            continue;
+        }
+        for (size_t j = 0; j < matches.size(); j++)
+        {
+            uintptr_t end = matches[j].addr + mb.dataSize();
+
+            if (spans.empty() || spans.back().block != i || matches[j].addr > spans.back().end + sparseGap)
+            {
+                spans.push_back({i, j, j+1, matches[j].addr, end});
+            }
+            else
+            {
+                spans.back().lastMatch = j+1;
+                spans.back().end = end;
+            }
+        }
+    }
+
+    while (first < spans.size())
+    {
+        std::vector<ReadRequest> requests;
+        std::vector<char> staging;
+        size_t batchSize = 0;
+        size_t last = first;
+
+        while (last < spans.size() && (last == first || batchSize + spans[last].size() <= batchBytes))
+        {
+            batchSize += spans[last].size();
+            last++;
+        }
+
+        staging.resize(batchSize);
+        batchSize = 0;
+        for (size_t i = first; i < last; i++)
+        {
+            requests.push_back({reinterpret_cast<char*>(spans[i].begin), staging.data() + batchSize, spans[i].size(), 0});
+            batchSize += spans[i].size();
+        }
+        Process::readBatch(pHandle, requests);
+
+        for (size_t i = first; i < last; i++)
+        {
+            filter(spans[i], requests[i-first]);
+        }
+        first = last;
+    }
+
+    for (auto& mb : memblocks)
+    {
+        if (mb.isSparse())
+        {
+            std::vector<SparseMatch>& matches = mb.sparseMatches();
+
+            matches.erase(std::remove_if(matches.begin(), matches.end(), 
+                                         [](const SparseMatch& match) { return match.addr == 0; }), 
+                          matches.end());
+            mb.matches() = matches.size();
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+#include "memblock.hpp"
+#include "process.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Values of a block starting in [begin, end) that one worker filters. data points to the new value at begin
+ * and holds read data up to limit, so values near end can reach past it. All offsets are relative to the block.
+ */
+struct ScanChunk
+{
+    size_t block;
+    const char* data;
+    size_t begin;
+    size_t end;
+    size_t storeEnd;
+    size_t limit;
+};
+
+/**
+ * \brief Part of a block that is read with one request. Values start in [begin, end), reading continues up to
+ * readEnd. New values are stored up to storeEnd, which stops at the next segment of the block so that its previous
+ * values stay untouched until it has been filtered itself.
+ */
+struct ReadSegment
+{
+    size_t block;
+    size_t begin;
+    size_t end;
+    size_t readEnd;
+    size_t storeEnd;
+};
+
+/**
+ * \brief Survivors [firstMatch, lastMatch) of a sparse block that are read with one request covering [begin, end)
+ */
+struct SparseSpan
+{
+    size_t block;
+    size_t firstMatch;
+    size_t lastMatch;
+    uintptr_t begin;
+    uintptr_t end;
+
+    size_t size() const { return end - begin; }
+};
+
+/**
+ * \brief Segments read together with one vectored read, and the staging buffer they were read into
+ */
+struct ReadBatch
+{
+    std::vector<MemBlock*> blocks;
+    std::vector<ReadSegment> segments;
+    std::vector<ReadRequest> requests;
+    std::vector<char> staging;
+};
+
+/**
+ * \brief Streams MemBlocks through a pool of fixed-size read buffers.
+ *
+ * Only pages whose search mask still has bits set are read, runs of live pages separated by less than segmentGap
+ * become one ReadSegment. A reader thread fills the free ReadBatches of the pool with up to batchBytes of segments
+ * each while the caller filters the batch it got from next(), so remote reads overlap with filtering and temporary
+ * memory stays at bufferCount * batchBytes whatever the size of the target.
+ * \param pHandle Process handle
+ * \param memblocks Vector of MemBlocks. Must not change while the reader exists.
+ * \param overlap Bytes that a value reaches past its start, minus one. 0 for aligned integers.
+ */
+class BlockReader
+{
+    public:
+        typedef std::function<void(const SparseSpan& span, const ReadRequest& read)> SpanFilter;
+
+        BlockReader(ProcessHandle pHandle, std::vector<MemBlock>& memblocks, size_t overlap);
+        ~BlockReader();
+
+        BlockReader(const BlockReader&) = delete;
+        BlockReader& operator=(const BlockReader&) = delete;
+
+        bool next();
+        std::vector<ScanChunk> chunks() const;
+        void store(const ScanChunk& chunk);
+
+        static void readSparse(ProcessHandle pHandle, std::vector<MemBlock>& memblocks, const SpanFilter& filter);
+
+              std::vector<MemBlock*>&    blocks()         { return m_batches[m_current].blocks; }
+        const std::vector<MemBlock*>&    blocks()   const { return m_batches[m_current].blocks; }
+              std::vector<ReadRequest>&  requests()       { return m_batches[m_current].requests; }
+        const std::vector<ReadRequest>&  requests() const { return m_batches[m_current].requests; }
+
+        const static inline size_t pageSize = 4096;
+        const static inline size_t segmentGap = 16 * pageSize;
+        const static inline size_t batchBytes = 8 << 20;
+        const static inline size_t bufferCount = 3;
+        // multiple of 64 so that chunks never share a search mask byte or split an element
+        const static inline size_t chunkBytes = 1 << 20;
+        // sparse survivors closer than this are read with a single request
+        const static inline size_t sparseGap = 4096;
+
+    private:
+        ProcessHandle m_pHandle;
+        std::vector<MemBlock>& m_memblocks;
+        size_t m_overlap;
+        std::vector<ReadSegment> m_segments;
+        ReadBatch m_batches[bufferCount];
+        std::deque<size_t> m_free;
+        std::deque<size_t> m_filled;
+        size_t m_current;
+        bool m_readDone;
+        bool m_stop;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::thread m_thread;
+
+        bool isPageLive(const MemBlock& mb, size_t page) const;
+        void findSegments(size_t block);
+        void fillBatch(ReadBatch& batch, size_t& nextSegment);
+        void readLoop();
+        void dropUnread(const ReadSegment& segment, const ReadRequest& read);
+};
\ No newline at end of file
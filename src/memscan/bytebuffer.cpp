@@ -0,0 +1,63 @@
+#include "bytebuffer.hpp"
+
+#include <utility>
+
+ByteBuffer::ByteBuffer()
+    : m_data(nullptr)
+    , m_size(0)
+{}
+
+ByteBuffer::ByteBuffer(ByteBuffer&& other)
+    : m_owned(std::move(other.m_owned))
+    , m_file(std::move(other.m_file))
+    , m_data(other.m_data)
+    , m_size(other.m_size)
+{
+    other.m_data = nullptr;
+    other.m_size = 0;
+}
+
+ByteBuffer& ByteBuffer::operator=(ByteBuffer&& other)
+{
+    m_owned = std::move(other.m_owned);
+    m_file = std::move(other.m_file);
+    m_data = other.m_data;
+    m_size = other.m_size;
+    other.m_data = nullptr;
+    other.m_size = 0;
+
+    return *this;
+}
+
+/**
+ * \brief Switch to owned memory of size bytes, all set to value. A mapped view is dropped.
+ */
+void ByteBuffer::resize(size_t size, char value)
+{
+    m_file.reset();
+    m_owned.assign(size, value);
+    m_data = m_owned.data();
+    m_size = size;
+}
+
+/**
+ * \brief Become a view of size bytes at offset of file. The caller checks that the range lies within the file.
+ */
+void ByteBuffer::map(std::shared_ptr<MappedFile> file, size_t offset, size_t size)
+{
+    std::vector<char>().swap(m_owned);
+    m_file = file;
+    m_data = m_file->data() + offset;
+    m_size = size;
+}
+
+/**
+ * \brief Release the memory or the view
+ */
+void ByteBuffer::clear()
+{
+    std::vector<char>().swap(m_owned);
+    m_file.reset();
+    m_data = nullptr;
+    m_size = 0;
+}
\ No newline at end of file
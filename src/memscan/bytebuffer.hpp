@@ -0,0 +1,45 @@
+#pragma once
+#include "mappedfile.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * \brief Byte array that either owns its memory or is a view into a MappedFile.
+ *
+ * Mapped views are copy on write, so both kinds can be written to alike. This lets MemBlocks loaded from a session
+ * file use the file's pages directly instead of copying them.
+ */
+class ByteBuffer
+{
+    public:
+        ByteBuffer();
+        ByteBuffer(ByteBuffer&& other);
+        ByteBuffer& operator=(ByteBuffer&& other);
+
+        ByteBuffer(const ByteBuffer&) = delete;
+        ByteBuffer& operator=(const ByteBuffer&) = delete;
+
+        void resize(size_t size, char value = 0);
+        void map(std::shared_ptr<MappedFile> file, size_t offset, size_t size);
+        void clear();
+
+        bool empty() const { return m_size == 0; }
+
+              char&  operator[](size_t i)       { return m_data[i]; }
+        const char&  operator[](size_t i) const { return m_data[i]; }
+              char*  data()                     { return m_data; }
+        const char*  data()               const { return m_data; }
+              char*  begin()                    { return m_data; }
+        const char*  begin()              const { return m_data; }
+              char*  end()                      { return m_data + m_size; }
+        const char*  end()                const { return m_data + m_size; }
+        const size_t& size()              const { return m_size; }
+
+    private:
+        std::vector<char> m_owned;
+        std::shared_ptr<MappedFile> m_file;
+        char* m_data;
+        size_t m_size;
+};
\ No newline at end of file
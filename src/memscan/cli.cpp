@@ -0,0 +1,188 @@
+#include "cli.hpp"
+#include "process.hpp"
+#include "scanplan.hpp"
+#include "server.hpp"
+#include "snapshot.hpp"
+#include "snapshotdiff.hpp"
+#include "threadpool.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+namespace
+{
+    Server* servedServer = nullptr;
+
+    void stopServer(int)
+    {
+        servedServer->stop();
+    }
+}
+
+/**
+ * \brief Write a snapshot of all writable memory of a process to path
+ * \return Exit code of the program
+ */
+int Cli::dump(int processId, const std::string& path, const RegionFilter& filter)
+{
+    ProcessHandle pHandle = Process::open(processId);
+
+    if (!Process::isValid(pHandle))
+    {
+        std::cerr << "Can't open process " << processId << "\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool written = Snapshot::dump(pHandle, processId, path, filter);
+    Process::close(pHandle);
+
+    if (!written)
+    {
+        std::cerr << "Can't write " << path << "\n";
+        return 1;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cerr << "Dumped process " << processId << " to " << path << " in " << elapsed.count() << "s\n";
+    return 0;
+}
+
+/**
+ * \brief Write the values of afterPath that meet condition compared to beforePath to stdout
+ * \return Exit code of the program
+ */
+int Cli::diff(const std::string& beforePath, const std::string& afterPath, const std::string& condition,
+              int dataSize, int threadCount)
+{
+    Condition cond;
+    Kernels::FilterArgs args {};
+
+    if (!ScanPlan::parseIntCondition(condition, cond, args))
+    {
+        std::cerr << "Invalid condition " << condition << "\n";
+        return 1;
+    }
+    if (dataSize != 1 && dataSize != 2 && dataSize != 4 && dataSize != 8)
+    {
+        std::cerr << "Invalid size " << dataSize << "\n";
+        return 1;
+    }
+
+    Snapshot before(beforePath);
+    Snapshot after(afterPath);
+    if (!before.isValid() || !after.isValid())
+    {
+        std::cerr << "Invalid snapshot " << (before.isValid() ? afterPath : beforePath) << "\n";
+        return 1;
+    }
+    if (before.processId() != after.processId())
+    {
+        std::cerr << "Warning: snapshots of different processes\n";
+    }
+
+    ThreadPool pool(threadCount);
+    SnapshotDiff snapshotDiff(before, after, pool);
+    auto start = std::chrono::steady_clock::now();
+    size_t matches = snapshotDiff.run(cond, args, dataSize, std::cout);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cerr << matches << " matches in " << snapshotDiff.overlapBytes() << " bytes, " << elapsed.count() << "s\n";
+    return 0;
+}
+
+/**
+ * \brief Run a ScanPlan on a process and write its results to outputPath, or stdout if it's empty
+ * \param type i8, i16, i32, i64, f32 or f64, with a u suffix to also search unaligned addresses (e.g. i32u)
+ * \param format ndjson or csv
+ * \param filter Regions the scan is limited to
+ * \return Exit code of the program
+ */
+int Cli::plan(int processId, const std::string& type, const std::string& planPath, const std::string& format,
+              const std::string& outputPath, int threadCount, const RegionFilter& filter)
+{
+    bool unaligned = !type.empty() && type.back() == 'u';
+    std::string baseType = unaligned ? type.substr(0, type.size() - 1) : type;
+    bool isFloat = baseType == "f32" || baseType == "f64";
+    int dataSize = baseType == "i8" ? 1 : baseType == "i16" ? 2 : baseType == "i32" || baseType == "f32" ? 4 : 
+                   baseType == "i64" || baseType == "f64" ? 8 : 0;
+    std::string error;
+
+    if (dataSize == 0)
+    {
+        std::cerr << "Invalid type " << type << "\n";
+        return 1;
+    }
+    if (format != "ndjson" && format != "csv")
+    {
+        std::cerr << "Invalid format " << format << "\n";
+        return 1;
+    }
+
+    ScanPlan scanPlan(dataSize, isFloat);
+    std::ifstream planFile(planPath);
+    if (!planFile)
+    {
+        std::cerr << "Can't read " << planPath << "\n";
+        return 1;
+    }
+    if (!scanPlan.load(planFile, error))
+    {
+        std::cerr << planPath << ": " << error << "\n";
+        return 1;
+    }
+
+    std::ofstream outputFile;
+    if (!outputPath.empty())
+    {
+        outputFile.open(outputPath, std::ios::trunc);
+        if (!outputFile)
+        {
+            std::cerr << "Can't write " << outputPath << "\n";
+            return 1;
+        }
+    }
+
+    std::shared_ptr<ScanSession> session = ScanSession::open(processId, dataSize, unaligned, filter);
+    if (!session)
+    {
+        std::cerr << "Can't open process " << processId << "\n";
+        return 1;
+    }
+
+    ThreadPool pool(threadCount);
+    scanPlan.run(session, pool, format == "csv" ? FORMAT_CSV : FORMAT_NDJSON, 
+                 outputPath.empty() ? std::cout : outputFile);
+    return 0;
+}
+
+/**
+ * \brief Serve sessions on a Unix socket at path until SIGINT or SIGTERM
+ * \return Exit code of the program
+ */
+int Cli::serve(const std::string& path, int threadCount, std::chrono::microseconds freezeInterval,
+               const RegionFilter& filter)
+{
+    Server server(path, threadCount, freezeInterval, filter);
+
+    servedServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+
+    std::cerr << "Serving on " << path << "\n";
+    bool served = server.run();
+
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    servedServer = nullptr;
+    if (!served)
+    {
+        std::cerr << "Can't listen on " << path << "\n";
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
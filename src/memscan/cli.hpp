@@ -0,0 +1,21 @@
+#pragma once
+#include "regionfilter.hpp"
+
+#include <chrono>
+#include <string>
+
+/**
+ * \brief Commands that run without the interactive UI, selected by command line options
+ */
+class Cli
+{
+    public:
+        static int dump(int processId, const std::string& path, const RegionFilter& filter);
+        static int diff(const std::string& beforePath, const std::string& afterPath, const std::string& condition,
+                        int dataSize, int threadCount);
+        static int plan(int processId, const std::string& type, const std::string& planPath, 
+                        const std::string& format, const std::string& outputPath, int threadCount,
+                        const RegionFilter& filter);
+        static int serve(const std::string& path, int threadCount, std::chrono::microseconds freezeInterval,
+                         const RegionFilter& filter);
+};
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "blockreader.hpp"
+#include "floatscanner.hpp"
+#include "kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+/**
+ * \brief Only val itself
+ */
+FloatRange FloatRange::exact(double val)
+{
+    return {val, std::nextafter(val, std::numeric_limits<double>::infinity())};
+}
+
+/**
+ * \brief Values within epsilon of val, both ends included
+ */
+FloatRange FloatRange::epsilon(double val, double epsilon)
+{
+    return {val - epsilon, std::nextafter(val + epsilon, std::numeric_limits<double>::infinity())};
+}
+
+/**
+ * \brief Values that round to val at the given number of decimals, e.g. [3.135, 3.145) for 3.14
+ */
+FloatRange FloatRange::rounded(double val, int decimals)
+{
+    double scale = std::pow(10.0, decimals);
+    double rounded = std::round(val * scale);
+
+    return {(rounded - 0.5) / scale, (rounded + 0.5) / scale};
+}
+
+/**
+ * \brief Values from low to high, both ends included
+ */
+FloatRange FloatRange::between(double low, double high)
+{
+    return {low, std::nextafter(high, std::numeric_limits<double>::infinity())};
+}
+
+/**
+ * \brief Parse a float value. "=v" matches v exactly, "v~e" matches v +- e, "lo..hi" every value from lo to hi, and 
+ * plain "v" matches every value that rounds to v at the number of decimals typed.
+ * \param dataSize 4 for float, exact values are rounded to float first
+ */
+FloatRange FloatRange::parse(const std::string& s, int dataSize)
+{
+    size_t tilde = s.find('~');
+    size_t dots = s.find("..");
+
+    if (!s.empty() && s[0] == '=')
+    {
+        double val = std::strtod(s.c_str() + 1, nullptr);
+        return FloatRange::exact(dataSize == 4 ? static_cast<float>(val) : val);
+    }
+    if (dots != std::string::npos)
+    {
+        return FloatRange::between(std::strtod(s.c_str(), nullptr), std::strtod(s.c_str() + dots + 2, nullptr));
+    }
+    if (tilde != std::string::npos)
+    {
+        return FloatRange::epsilon(std::strtod(s.c_str(), nullptr), std::strtod(s.c_str() + tilde + 1, nullptr));
+    }
+
+    size_t dot = s.find('.');
+    int decimals = (dot == std::string::npos) ? 0 : static_cast<int>(s.size() - dot - 1);
+
+    return FloatRange::rounded(std::strtod(s.c_str(), nullptr), decimals);
+}
+
+FloatScanner::FloatScanner(std::shared_ptr<ScanSession> session, ThreadPool& pool)
+    : m_session(session)
+    , m_pool(pool)
+{}
+
+/**
+ * \brief Decode the bits of a value as stored in a SparseMatch
+ */
+double FloatScanner::toDouble(int64_t bits, int dataSize)
+{
+    if (dataSize == 8)
+    {
+        double val;
+        std::memcpy(&val, &bits, 8);
+        return val;
+    }
+
+    int32_t bits32 = static_cast<int32_t>(bits);
+    float val;
+    std::memcpy(&val, &bits32, 4);
+    return val;
+}
+
+/**
+ * \brief Filter the values of one chunk with the fastest kernel this CPU supports. Unaligned values may reach past 
+ * the end of the chunk, up to its limit.
+ * \return Number of matches in chunk
+ */
+size_t FloatScanner::updateSearch(MemBlock& mb, const ScanChunk& chunk, Condition condition, const FloatRange& range)
+{
+    bool aligned = (mb.stride() == mb.dataSize());
+    Kernels::Filter filter = Kernels::floatFilter(mb.dataSize(), condition, aligned);
+    size_t end = aligned ? chunk.end : std::min(chunk.end + mb.dataSize() - 1, chunk.limit);
+    Kernels::FilterArgs args = {0, 0, range.low, range.high};
+
+    return filter(chunk.data, mb.buffer().data() + chunk.begin, mb.searchMask().data(), chunk.begin, end, args);
+}
+
+/**
+ * \brief Filter one chunk of a block
+ * \return Number of matches in chunk
+ */
+size_t FloatScanner::updateChunk(MemBlock& mb, const ScanChunk& chunk, Condition condition, const FloatRange& range)
+{
+    if (condition == COND_UNCONDITIONAL) 
+    {
+        size_t firstIndex = chunk.begin / mb.stride();
+        size_t lastIndex = std::min((chunk.end + mb.stride() - 1) / mb.stride(), mb.elementCount(chunk.limit));
+
+        mb.fillSearch(firstIndex, lastIndex, true);
+        return lastIndex > firstIndex ? lastIndex - firstIndex : 0;
+    } 
+
+    return updateSearch(mb, chunk, condition, range);
+}
+
+/**
+ * \brief Whether updateScan can filter with a condition, there are no float kernels for the integer deltas and masks
+ */
+bool FloatScanner::supports(Condition condition)
+{
+    return condition >= COND_UNCONDITIONAL && condition <= COND_BETWEEN;
+}
+
+/**
+ * \brief Filter all blocks with a condition. Sparse survivors are compared as floating point, except for changed and
+ * unchanged, which compare the bits like the kernels. Conditions that aren't supported leave the matches unchanged.
+ */
+void FloatScanner::updateScan(Condition condition, const FloatRange& range) 
+{
+    if (!supports(condition))
+    {
+        return;
+    }
+
+    m_session->scanBlocks(m_pool,
+                          [&](MemBlock& mb, const ScanChunk& chunk, int)
+                          {
+                              return updateChunk(mb, chunk, condition, range);
+                          },
+                          [&](int64_t tempBits, int64_t prevBits)
+                          {
+                              return matchesCondition(condition, range, tempBits, prevBits);
+                          });
+}
+
+/**
+ * \brief Decide a condition for the survivor of a sparse block, from the bits of new and previous value
+ */
+bool FloatScanner::matchesCondition(Condition condition, const FloatRange& range, int64_t tempBits, 
+                                    int64_t prevBits) const
+{
+    double tempVal = toDouble(tempBits, dataSize());
+    double prevVal = toDouble(prevBits, dataSize());
+
+    switch (condition)
+    {
+        case COND_UNCONDITIONAL:
+            return true;
+        case COND_EQUALS:
+        case COND_BETWEEN:
+            return tempVal >= range.low && tempVal < range.high;
+        case COND_INCREASED:
+            return tempVal > prevVal;
+        case COND_DECREASED:
+            return tempVal < prevVal;
+        case COND_CHANGED:
+            return tempBits != prevBits;
+        case COND_UNCHANGED:
+            return tempBits == prevBits;
+        default:
+            return false;
+    }
+}
+
+void FloatScanner::writeFloat(uintptr_t addr, float val)
+{
+    if (!Process::write(pHandle(), addr, &val, 4))
+    {
+        std::cout << "writing failed\r\n";
+    }
+}
+
+void FloatScanner::writeDouble(uintptr_t addr, double val)
+{
+    if (!Process::write(pHandle(), addr, &val, 8))
+    {
+        std::cout << "writing failed\r\n";
+    }
+}
+
+float FloatScanner::readFloat(uintptr_t addr)
+{
+    float val = 0;
+
+    if (Process::read(pHandle(), reinterpret_cast<void*>(addr), &val, 4) != 4)
+    {
+        std::cout << "reading failed\r\n";
+    }
+
+    return val;
+}
+
+double FloatScanner::readDouble(uintptr_t addr)
+{
+    double val = 0;
+
+    if (Process::read(pHandle(), reinterpret_cast<void*>(addr), &val, 8) != 8)
+    {
+        std::cout << "reading failed\r\n";
+    }
+
+    return val;
+}
\ No newline at end of file
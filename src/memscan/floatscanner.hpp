@@ -0,0 +1,59 @@
+#pragma once
+#include "blockreader.hpp"
+#include "memblock.hpp"
+#include "process.hpp"
+#include "scansession.hpp"
+#include "threadpool.hpp"
+
+#include <memory>
+#include <string>
+
+/**
+ * \brief Values v with low <= v < high are taken as equal to the searched value
+ */
+struct FloatRange
+{
+    double low;
+    double high;
+
+    static FloatRange exact(double val);
+    static FloatRange epsilon(double val, double epsilon);
+    static FloatRange rounded(double val, int decimals);
+    static FloatRange between(double low, double high);
+    static FloatRange parse(const std::string& s, int dataSize);
+};
+
+/**
+ * \brief Floating point scanner for float (dataSize 4) and double (dataSize 8) values. Only the conditions up to
+ * COND_BETWEEN have float kernels, updateScan leaves the matches alone for INCREASED_BY, DECREASED_BY and BITMASK.
+ * \param session Scan session, shared with the Scanner
+ * \param pool Thread pool used for filtering
+ */
+class FloatScanner
+{
+    public:
+        FloatScanner(std::shared_ptr<ScanSession> session, ThreadPool& pool);
+
+        static bool supports(Condition condition);
+
+        void updateScan(Condition condition, const FloatRange& range);
+        void writeFloat(uintptr_t addr, float val);
+        void writeDouble(uintptr_t addr, double val);
+        float readFloat(uintptr_t addr);
+        double readDouble(uintptr_t addr);
+
+        static double toDouble(int64_t bits, int dataSize);
+
+        const ProcessHandle&         pHandle()   const { return m_session->pHandle(); }
+              std::vector<MemBlock>& memblocks()       { return m_session->memblocks(); }
+        const std::vector<MemBlock>& memblocks() const { return m_session->memblocks(); }
+        const int&                   dataSize()  const { return m_session->dataSize(); }
+
+    private:
+        std::shared_ptr<ScanSession> m_session;
+        ThreadPool& m_pool;
+        
+        size_t updateSearch(MemBlock& mb, const ScanChunk& chunk, Condition condition, const FloatRange& range);
+        size_t updateChunk(MemBlock& mb, const ScanChunk& chunk, Condition condition, const FloatRange& range);
+        bool matchesCondition(Condition condition, const FloatRange& range, int64_t tempBits, int64_t prevBits) const;
+};
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include "freezer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+Freezer::Freezer(std::shared_ptr<ScanSession> session, std::chrono::microseconds interval)
+    : m_session(session)
+    , m_interval(interval)
+    , m_failedWrites(0)
+    , m_changed(false)
+    , m_stop(false)
+{
+    m_thread = std::thread(&Freezer::writeLoop, this);
+}
+
+Freezer::~Freezer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+}
+
+/**
+ * \brief Add a value to the list or replace the frozen content of addr
+ * \param value Bytes written to addr on every tick
+ */
+void Freezer::freeze(uintptr_t addr, const void* value, size_t size)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const char* bytes = static_cast<const char*>(value);
+
+        m_values[addr].assign(bytes, bytes + size);
+        m_changed = true;
+    }
+    m_wake.notify_all();
+}
+
+void Freezer::unfreeze(uintptr_t addr)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_changed = m_values.erase(addr) > 0 || m_changed;
+    }
+    m_wake.notify_all();
+}
+
+void Freezer::clear()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_values.clear();
+        m_changed = true;
+    }
+    m_wake.notify_all();
+}
+
+void Freezer::setInterval(std::chrono::microseconds interval)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_interval = interval;
+    }
+    m_wake.notify_all();
+}
+
+std::map<uintptr_t, std::vector<char>> Freezer::frozen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_values;
+}
+
+/**
+ * \brief Number of ticks that couldn't write every frozen value, e.g. because the memory was unmapped
+ */
+size_t Freezer::failedWrites() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_failedWrites;
+}
+
+/**
+ * \brief Merge the sorted list into runs of adjacent or overlapping values and group runs that share a page into one
+ * span. image holds the bytes of all runs, where two values overlap the one at the higher address wins. Called with
+ * m_mutex held.
+ */
+void Freezer::buildPlan(FreezePlan& plan) const
+{
+    std::vector<size_t> starts;
+    uintptr_t runEnd = 0;
+
+    plan.image.clear();
+    plan.runs.clear();
+    plan.runOffsets.clear();
+    plan.spans.clear();
+    for (auto& [addr, value] : m_values)
+    {
+        if (plan.runs.empty() || addr > runEnd)
+        {
+            plan.runs.push_back({reinterpret_cast<char*>(addr), nullptr, 0, 0});
+            starts.push_back(plan.image.size());
+            runEnd = addr;
+        }
+
+        uintptr_t runStart = reinterpret_cast<uintptr_t>(plan.runs.back().addr);
+        size_t end = std::max<uintptr_t>(runEnd, addr + value.size()) - runStart;
+
+        plan.image.resize(starts.back() + end);
+        std::memcpy(plan.image.data() + starts.back() + (addr - runStart), value.data(), value.size());
+        plan.runs.back().size = end;
+        runEnd = runStart + end;
+    }
+
+    size_t currentSize = 0;
+    for (size_t i = 0; i < plan.runs.size(); i++)
+    {
+        uintptr_t runStart = reinterpret_cast<uintptr_t>(plan.runs[i].addr);
+        // a span continues as long as the next run starts on the page it ends on
+        bool samePage = !plan.spans.empty() && 
+            runStart / pageSize == (reinterpret_cast<uintptr_t>(plan.spans.back().addr) + plan.spans.back().size - 1) 
+                                   / pageSize;
+
+        if (!samePage)
+        {
+            plan.spans.push_back({plan.runs[i].addr, nullptr, 0, 0});
+        }
+
+        size_t spanOffset = runStart - reinterpret_cast<uintptr_t>(plan.spans.back().addr);
+        currentSize += spanOffset + plan.runs[i].size - plan.spans.back().size;
+        plan.spans.back().size = spanOffset + plan.runs[i].size;
+        plan.runOffsets.push_back(currentSize - plan.runs[i].size);
+    }
+
+    // both buffers are complete, so they don't move anymore
+    plan.current.resize(currentSize);
+    for (size_t i = 0, offset = 0; i < plan.spans.size(); i++)
+    {
+        plan.spans[i].buffer = plan.current.data() + offset;
+        offset += plan.spans[i].size;
+    }
+    for (size_t i = 0; i < plan.runs.size(); i++)
+    {
+        plan.runs[i].buffer = plan.image.data() + starts[i];
+    }
+}
+
+/**
+ * \brief Read the spans and rewrite every run that doesn't hold its frozen bytes anymore
+ * \return False if a span couldn't be read or a run couldn't be written
+ */
+bool Freezer::tick(FreezePlan& plan, std::vector<WriteRequest>& writes) const
+{
+    bool complete = true;
+    size_t span = 0;
+
+    Process::readBatch(m_session->pHandle(), plan.spans);
+    writes.clear();
+    for (size_t i = 0; i < plan.runs.size(); i++)
+    {
+        const WriteRequest& run = plan.runs[i];
+
+        while (plan.spans[span].addr + plan.spans[span].size < run.addr + run.size)
+        {
+            span++;
+        }
+        complete = complete && plan.spans[span].bytesRead == plan.spans[span].size;
+        if (std::memcmp(plan.current.data() + plan.runOffsets[i], run.buffer, run.size) != 0)
+        {
+            writes.push_back(run);
+        }
+    }
+
+    if (!writes.empty())
+    {
+        Process::writeBatch(m_session->pHandle(), writes);
+    }
+
+    return complete && std::all_of(writes.begin(), writes.end(),
+                                   [](const WriteRequest& req) { return req.bytesWritten == req.size; });
+}
+
+/**
+ * \brief Rewrite the list every interval. The list is only locked to pick up changes, never during the remote calls.
+ */
+void Freezer::writeLoop()
+{
+    FreezePlan plan;
+    std::vector<WriteRequest> writes;
+    auto nextTick = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_stop)
+    {
+        if (m_values.empty())
+        {
+            m_wake.wait(lock, [this] { return m_stop || !m_values.empty(); });
+            nextTick = std::chrono::steady_clock::now();
+            continue;
+        }
+        if (m_changed)
+        {
+            buildPlan(plan);
+            m_changed = false;
+        }
+
+        lock.unlock();
+        bool complete = tick(plan, writes);
+        lock.lock();
+
+        m_failedWrites += !complete;
+        // a slow tick is not made up for with a burst of writes
+        nextTick = std::max(nextTick + m_interval, std::chrono::steady_clock::now());
+        m_wake.wait_until(lock, nextTick, [this] { return m_stop || m_changed; });
+    }
+}
\ No newline at end of file
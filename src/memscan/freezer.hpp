@@ -0,0 +1,71 @@
+#pragma once
+#include "process.hpp"
+#include "scansession.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Keeps values at a fixed content by rewriting them from a background thread.
+ *
+ * The freeze list is sorted by address. Whenever it changes, the thread turns it into runs of adjacent values and
+ * groups the runs by page. Every tick reads the frozen part of each page with one Process::readBatch and rewrites
+ * only the runs that drifted with one Process::writeBatch. The kernel pins pages per iovec, so thousands of values
+ * cost a few dozen page reads per tick instead of thousands of writes. The thread sleeps between ticks and waits
+ * without a timeout while the list is empty.
+ * \param session Scan session, shared with the Scanner
+ * \param interval Time between two rewrites of the list
+ */
+class Freezer
+{
+    public:
+        Freezer(std::shared_ptr<ScanSession> session, std::chrono::microseconds interval);
+        ~Freezer();
+
+        Freezer(const Freezer&) = delete;
+        Freezer& operator=(const Freezer&) = delete;
+
+        void freeze(uintptr_t addr, const void* value, size_t size);
+        void unfreeze(uintptr_t addr);
+        void clear();
+        void setInterval(std::chrono::microseconds interval);
+
+        std::map<uintptr_t, std::vector<char>> frozen() const;
+        size_t failedWrites() const;
+
+    private:
+        /**
+         * \brief Requests of one tick. runs[i] is compared with the bytes at runOffsets[i] of current, which the page
+         * spans are read into.
+         */
+        struct FreezePlan
+        {
+            std::vector<char> image;
+            std::vector<char> current;
+            std::vector<WriteRequest> runs;
+            std::vector<size_t> runOffsets;
+            std::vector<ReadRequest> spans;
+        };
+
+        std::shared_ptr<ScanSession> m_session;
+        std::map<uintptr_t, std::vector<char>> m_values;
+        std::chrono::microseconds m_interval;
+        size_t m_failedWrites;
+        bool m_changed;
+        bool m_stop;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::thread m_thread;
+
+        void writeLoop();
+        void buildPlan(FreezePlan& plan) const;
+        bool tick(FreezePlan& plan, std::vector<WriteRequest>& writes) const;
+
+        const static inline size_t pageSize = 4096;
+};
\ No newline at end of file
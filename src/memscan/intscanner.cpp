@@ -1,121 +1,211 @@
+#include "blockreader.hpp"
 #include "intscanner.hpp"
+#include "kernels.hpp"
+#include "valueset.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
-#include <memoryapi.h>
 
-IntScanner::IntScanner(std::vector<MemBlock> memblocks): m_pHandle(memblocks[0].pHandle()), m_memblocks(memblocks)
+namespace
+{
+    /**
+     * \brief Wrap a value around like an integer of dataSize bytes does
+     */
+    int64_t truncate(int64_t val, int dataSize)
+    {
+        int shift = 64 - 8*dataSize;
+        return static_cast<int64_t>(static_cast<uint64_t>(val) << shift) >> shift;
+    }
+}
+
+IntScanner::IntScanner(std::shared_ptr<ScanSession> session, ThreadPool& pool)
+    : m_session(session)
+    , m_pool(pool)
 {}
 
-IntScanner::~IntScanner()
+/**
+ * \brief Filter the values of one chunk with the fastest kernel this CPU supports. Unaligned values may reach past 
+ * the end of the chunk, up to its limit.
+ * \return Number of matches in chunk
+ */
+size_t IntScanner::updateSearch(MemBlock& mb, const ScanChunk& chunk, Condition condition, 
+                                const Kernels::FilterArgs& args)
 {
-    CloseHandle(m_pHandle);
+    bool aligned = (mb.stride() == mb.dataSize());
+    Kernels::Filter filter = Kernels::intFilter(mb.dataSize(), condition, aligned);
+    size_t end = aligned ? chunk.end : std::min(chunk.end + mb.dataSize() - 1, chunk.limit);
+
+    return filter(chunk.data, mb.buffer().data() + chunk.begin, mb.searchMask().data(), chunk.begin, end, args);
 }
 
-void IntScanner::updateSearch(MemBlock& mb, 
-                              int bytesRead, 
-                              std::string& tempBuf, 
-                              Condition condition, 
-                              int64_t val)
+/**
+ * \brief Filter one chunk of a block
+ * \return Number of matches in chunk
+ */
+size_t IntScanner::updateChunk(MemBlock& mb, const ScanChunk& chunk, Condition condition, 
+                               const Kernels::FilterArgs& args)
 {
-    for (int offset = 0; offset < bytesRead; offset += mb.dataSize()) 
+    if (condition == COND_UNCONDITIONAL) 
     {
-        if (mb.isInSearch(offset))
-        {
-            bool isMatch = false; 
-            int64_t tempVal;
-            int64_t prevVal = 0;
-            char* tempBuffer;
-            char* prevBuffer;
-
-            switch (mb.dataSize())
-            {
-                case 1:
-                    tempVal = tempBuf[offset];
-                    prevVal = mb.buffer()[offset];
-                    break;
-                case 2:
-                    tempVal = *reinterpret_cast<int16_t*>(&tempBuf[offset]);
-                    prevVal = *reinterpret_cast<int16_t*>(&mb.buffer()[offset]);
-                    break;
-                case 4:
-                default:
-                    tempVal = *reinterpret_cast<int32_t*>(&tempBuf[offset]);
-                    prevVal = *reinterpret_cast<int32_t*>(&mb.buffer()[offset]);
-                    break;
-                case 8:
-                    tempVal = *reinterpret_cast<int64_t*>(&tempBuf[offset]);
-                    prevVal = *reinterpret_cast<int64_t*>(&mb.buffer()[offset]);
-                    break;
-            }
-            
-            switch (condition) 
-            {
-                case COND_EQUALS:
-                    isMatch = (tempVal == val);
-                    break;
-                case COND_INCREASED:
-                    isMatch = (tempVal > prevVal);
-                    break;
-                case COND_DECREASED:
-                    isMatch = (tempVal < prevVal);
-                    break;
-                default:
-                    break;
-            }
-
-            if (isMatch) 
-            {
-                mb.matches() = mb.matches()+1;
-            } 
-            else
-            {
-                mb.removeFromSearch(offset);
-            }
-        }
-    }
+        size_t firstIndex = chunk.begin / mb.stride();
+        size_t lastIndex = std::min((chunk.end + mb.stride() - 1) / mb.stride(), mb.elementCount(chunk.limit));
+
+        mb.fillSearch(firstIndex, lastIndex, true);
+        return lastIndex > firstIndex ? lastIndex - firstIndex : 0;
+    } 
+
+    return updateSearch(mb, chunk, condition, args);
 }
 
-void IntScanner::updateMemBlock(MemBlock& mb, Condition condition, int64_t val)
+/**
+ * \brief Filter the values of one chunk against a set: the SIMD range kernel drops everything outside 
+ * [set.min(), set.max()], the survivors are looked up in the set and counted per value.
+ * \return Number of matches in chunk
+ */
+size_t IntScanner::updateSetChunk(MemBlock& mb, const ScanChunk& chunk, const ValueSet& set, std::vector<size_t>& hits)
 {
-    std::string tempBuf;
-    int bytesToRead;
-    SIZE_T bytesRead;
+    Kernels::FilterArgs args = {set.min(), set.max(), 0, 0};
+    size_t matches = 0;
 
-    tempBuf.resize(mb.size());
+    if (updateSearch(mb, chunk, COND_BETWEEN, args) == 0)
+    {
+        return 0;
+    }
 
-    if (mb.size() > 0) 
+    for (size_t offset = chunk.begin; offset < chunk.end; offset += mb.stride())
     {
-        mb.matches() = 0;
+        size_t index = offset / mb.stride();
+
+        if (index % 8 == 0 && mb.searchMask()[index/8] == 0)
+        {
+            offset += 7 * mb.stride();
+            continue;
+        }
+        if (!mb.isInSearch(offset))
+        {
+            continue;
+        }
 
-        bytesToRead = mb.size();
-        ReadProcessMemory(m_pHandle, mb.addr(), &tempBuf[0], bytesToRead, &bytesRead);
-        if (condition == COND_UNCONDITIONAL) 
+        int found = set.find(MemBlock::toInt(chunk.data + (offset - chunk.begin), mb.dataSize()));
+        if (found < 0)
         {
-            std::fill(mb.searchMask().begin(), mb.searchMask().begin()+bytesRead/8, 0xff);
-            mb.matches() += bytesRead;
-        } 
+            mb.removeFromSearch(offset);
+        }
         else
         {
-            updateSearch(mb, bytesRead, tempBuf, condition, val);
+            hits[found]++;
+            matches++;
         }
+    }
 
-        std::memcpy(mb.buffer().data(), &tempBuf[0], bytesRead);
-        mb.size() = bytesRead;
+    return matches;
+}
+
+/**
+ * \brief Filter all blocks with a condition
+ * \param val Value for COND_EQUALS and COND_BITMASK, lower bound for COND_BETWEEN, difference for COND_INCREASED_BY and
+ * COND_DECREASED_BY
+ * \param val2 Inclusive upper bound for COND_BETWEEN, mask for COND_BITMASK
+ */
+void IntScanner::updateScan(Condition condition, int64_t val, int64_t val2) 
+{
+    Kernels::FilterArgs args = {val, val2, 0, 0};
+
+    m_session->scanBlocks(m_pool,
+                          [&](MemBlock& mb, const ScanChunk& chunk, int)
+                          {
+                              return updateChunk(mb, chunk, condition, args);
+                          },
+                          [&](int64_t tempVal, int64_t prevVal)
+                          {
+                              return matchesCondition(condition, args, tempVal, prevVal);
+                          });
+}
+
+/**
+ * \brief Keep the values that are in a set, all of them found with one read of the process
+ * \return Number of matches of each value in set.values()
+ */
+std::vector<size_t> IntScanner::updateScanSet(const ValueSet& set)
+{
+    std::vector<std::vector<size_t>> workerHits(m_pool.threadCount(), std::vector<size_t>(set.values().size(), 0));
+    std::vector<size_t> hits(set.values().size(), 0);
+
+    if (set.empty())
+    {
+        for (auto& mb : memblocks())
+        {
+            mb.matches() = 0;
+        }
+        MemBlock::removeDead(memblocks());
+        return hits;
     }
+
+    // sparse blocks are filtered before the pool runs, so their hits can go to the counts of worker 0
+    m_session->scanBlocks(m_pool,
+                          [&](MemBlock& mb, const ScanChunk& chunk, int worker)
+                          {
+                              return updateSetChunk(mb, chunk, set, workerHits[worker]);
+                          },
+                          [&](int64_t tempVal, int64_t)
+                          {
+                              int found = set.find(tempVal);
+                              if (found >= 0)
+                              {
+                                  workerHits[0][found]++;
+                              }
+                              return found >= 0;
+                          });
+
+    for (auto& worker : workerHits)
+    {
+        for (size_t i = 0; i < hits.size(); i++)
+        {
+            hits[i] += worker[i];
+        }
+    }
+
+    return hits;
 }
 
-void IntScanner::updateScan(Condition condition, int64_t val) 
+/**
+ * \brief Decide a condition for the survivor of a sparse block. Differences and masked values wrap around like the 
+ * dense kernels do.
+ */
+bool IntScanner::matchesCondition(Condition condition, const Kernels::FilterArgs& args, int64_t tempVal, 
+                                  int64_t prevVal) const
 {
-    for (auto& mb : m_memblocks)
+    switch (condition)
     {
-        updateMemBlock(mb, condition, val);
+        case COND_UNCONDITIONAL:
+            return true;
+        case COND_EQUALS:
+            return tempVal == args.val;
+        case COND_INCREASED:
+            return tempVal > prevVal;
+        case COND_DECREASED:
+            return tempVal < prevVal;
+        case COND_CHANGED:
+            return tempVal != prevVal;
+        case COND_UNCHANGED:
+            return tempVal == prevVal;
+        case COND_BETWEEN:
+            return tempVal >= args.val && tempVal <= args.val2;
+        case COND_INCREASED_BY:
+            return truncate(tempVal - prevVal, dataSize()) == truncate(args.val, dataSize());
+        case COND_DECREASED_BY:
+            return truncate(prevVal - tempVal, dataSize()) == truncate(args.val, dataSize());
+        case COND_BITMASK:
+            return truncate(tempVal & args.val2, dataSize()) == truncate(args.val, dataSize());
     }
+
+    return false;
 }
 
 void IntScanner::writeInt8(uintptr_t addr, char val)
 {
-    if (!WriteProcessMemory(m_pHandle, reinterpret_cast<uintptr_t*>(addr), &val, 1, nullptr))
+    if (!Process::write(pHandle(), addr, &val, 1))
     {
         std::cout << "writing failed\r\n";
     }
@@ -123,7 +213,7 @@ void IntScanner::writeInt8(uintptr_t addr, char val)
 
 void IntScanner::writeInt16(uintptr_t addr, int16_t val)
 {
-    if (!WriteProcessMemory(m_pHandle, reinterpret_cast<uintptr_t*>(addr), &val, 2, nullptr))
+    if (!Process::write(pHandle(), addr, &val, 2))
     {
         std::cout << "writing failed\r\n";
     }
@@ -131,7 +221,7 @@ void IntScanner::writeInt16(uintptr_t addr, int16_t val)
 
 void IntScanner::writeInt32(uintptr_t addr, int32_t val)
 {
-    if (!WriteProcessMemory(m_pHandle, reinterpret_cast<uintptr_t*>(addr), &val, 4, NULL))
+    if (!Process::write(pHandle(), addr, &val, 4))
     {
         std::cout << "writing failed\r\n";
     }
@@ -139,7 +229,7 @@ void IntScanner::writeInt32(uintptr_t addr, int32_t val)
 
 void IntScanner::writeInt64(uintptr_t addr, int64_t val)
 {
-    if (!WriteProcessMemory(m_pHandle, reinterpret_cast<uintptr_t*>(addr), &val, 8, nullptr))
+    if (!Process::write(pHandle(), addr, &val, 8))
     {
         std::cout << "writing failed\r\n";
     }
@@ -149,7 +239,7 @@ char IntScanner::readInt8(uintptr_t addr)
 {
     char val = 0;
 
-    if (!ReadProcessMemory(m_pHandle, reinterpret_cast<char*>(addr), &val, 1, nullptr))
+    if (Process::read(pHandle(), reinterpret_cast<void*>(addr), &val, 1) != 1)
     {
         std::cout << "reading failed\r\n";
     }
@@ -161,7 +251,7 @@ int16_t IntScanner::readInt16(uintptr_t addr)
 {
     int16_t val = 0;
 
-    if (!ReadProcessMemory(m_pHandle, reinterpret_cast<int16_t*>(addr), &val, 2, nullptr))
+    if (Process::read(pHandle(), reinterpret_cast<void*>(addr), &val, 2) != 2)
     {
         std::cout << "reading failed\r\n";
     }
@@ -173,7 +263,7 @@ int32_t IntScanner::readInt32(uintptr_t addr)
 {
     int32_t val = 0;
 
-    if (!ReadProcessMemory(m_pHandle, reinterpret_cast<int32_t*>(addr), &val, 4, nullptr))
+    if (Process::read(pHandle(), reinterpret_cast<void*>(addr), &val, 4) != 4)
     {
         std::cout << "reading failed\r\n";
     }
@@ -185,7 +275,7 @@ int64_t IntScanner::readInt64(uintptr_t addr)
 {
     int64_t val = 0;
 
-    if (!ReadProcessMemory(m_pHandle, reinterpret_cast<int64_t*>(addr), &val, 8, nullptr))
+    if (Process::read(pHandle(), reinterpret_cast<void*>(addr), &val, 8) != 8)
     {
         std::cout << "reading failed\r\n";
     }
@@ -1,19 +1,28 @@
 #pragma once
+#include "blockreader.hpp"
+#include "kernels.hpp"
 #include "memblock.hpp"
+#include "process.hpp"
+#include "scansession.hpp"
+#include "threadpool.hpp"
+#include "valueset.hpp"
 
+#include <memory>
 #include <string>
+#include <vector>
 
 /**
  * \brief Integer scanner for 8/16/32/64 bit signed integers
- * \param memblocks Vector of MemBlocks
+ * \param session Scan session, shared with the Scanner
+ * \param pool Thread pool used for filtering
  */
 class IntScanner
 {
     public:
-        IntScanner(std::vector<MemBlock> memblocks);
-        ~IntScanner();
+        IntScanner(std::shared_ptr<ScanSession> session, ThreadPool& pool);
 
-        void updateScan(Condition condition, int64_t val);
+        void updateScan(Condition condition, int64_t val, int64_t val2 = 0);
+        std::vector<size_t> updateScanSet(const ValueSet& set);
         void writeInt8(uintptr_t addr, char val);
         void writeInt16(uintptr_t addr, int16_t val);
         void writeInt32(uintptr_t addr, int32_t val);
@@ -23,15 +32,18 @@ class IntScanner
         int32_t readInt32(uintptr_t addr);
         int64_t readInt64(uintptr_t addr);
 
-              HANDLE&                pHandle()         { return m_pHandle; }
-        const HANDLE&                pHandle()   const { return m_pHandle; }
-              std::vector<MemBlock>& memblocks()       { return m_memblocks; }
-        const std::vector<MemBlock>& memblocks() const { return m_memblocks; }
+        const ProcessHandle&         pHandle()   const { return m_session->pHandle(); }
+              std::vector<MemBlock>& memblocks()       { return m_session->memblocks(); }
+        const std::vector<MemBlock>& memblocks() const { return m_session->memblocks(); }
+        const int&                   dataSize()  const { return m_session->dataSize(); }
 
     private:
-        HANDLE m_pHandle;
-        std::vector<MemBlock> m_memblocks;
-        
-        void updateSearch(MemBlock& mb, int bytesRead, std::string& tempBuf, Condition condition, int64_t val);
-        void updateMemBlock(MemBlock& mb, Condition condition, int64_t val);
+        std::shared_ptr<ScanSession> m_session;
+        ThreadPool& m_pool;
+
+        bool matchesCondition(Condition condition, const Kernels::FilterArgs& args, int64_t val, 
+                              int64_t prevVal) const;
+        size_t updateSearch(MemBlock& mb, const ScanChunk& chunk, Condition condition, const Kernels::FilterArgs& args);
+        size_t updateChunk(MemBlock& mb, const ScanChunk& chunk, Condition condition, const Kernels::FilterArgs& args);
+        size_t updateSetChunk(MemBlock& mb, const ScanChunk& chunk, const ValueSet& set, std::vector<size_t>& hits);
 };
\ No newline at end of file
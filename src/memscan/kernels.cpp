@@ -0,0 +1,1220 @@
+#include "kernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MEMSCAN_X86
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace
+{
+    // highest instruction set the kernels may use, see Kernels::limitInstructionSet
+    std::atomic<InstructionSet> isaLimit(ISA_AVX2);
+
+    /**
+     * \brief Bits of a movemask_epi8 result that belong to element starts, for elements of type T
+     */
+    template<typename T>
+    constexpr uint32_t strideBits()
+    {
+        return sizeof(T) == 1 ? 0xffffffff : sizeof(T) == 2 ? 0x55555555 : sizeof(T) == 4 ? 0x11111111 : 0x01010101;
+    }
+
+    template<typename T>
+    bool fitsType(int64_t val)
+    {
+        return static_cast<int64_t>(static_cast<T>(val)) == val;
+    }
+
+    /**
+     * \brief Smallest T that is not below x, so that a range converted to float keeps the same values
+     */
+    template<typename T>
+    T ceilTo(double x)
+    {
+        T result = static_cast<T>(x);
+
+        if (result < x)
+        {
+            result = std::nextafter(result, std::numeric_limits<T>::infinity());
+        }
+
+        return result;
+    }
+
+    /**
+     * \brief FilterArgs converted to the element type. COND_EQUALS on integers compares with the untruncated val, so
+     * that values that don't fit T never match. An empty COND_BETWEEN range becomes [max, min].
+     */
+    template<typename T>
+    struct Operands
+    {
+        int64_t val;
+        T low;
+        T high;
+        T mask;
+
+        Operands(const Kernels::FilterArgs& args)
+        {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                val = 0;
+                low = ceilTo<T>(args.low);
+                high = ceilTo<T>(args.high);
+                mask = 0;
+            }
+            else
+            {
+                const int64_t minVal = std::numeric_limits<T>::min();
+                const int64_t maxVal = std::numeric_limits<T>::max();
+
+                val = args.val;
+                if (args.val > args.val2 || args.val > maxVal || args.val2 < minVal)
+                {
+                    low = static_cast<T>(maxVal);
+                    high = static_cast<T>(minVal);
+                }
+                else
+                {
+                    low = static_cast<T>(std::max(args.val, minVal));
+                    high = static_cast<T>(std::min(args.val2, maxVal));
+                }
+                mask = static_cast<T>(args.val2);
+            }
+        }
+
+        /**
+         * \brief Values broadcast to the lanes of the SIMD kernels: the value or difference and the mask for integers, 
+         * the range for floats
+         */
+        template<Condition C>
+        void lanes(T& a, T& b) const
+        {
+            if (std::is_floating_point_v<T> || C == COND_BETWEEN)
+            {
+                a = low;
+                b = high;
+            }
+            else
+            {
+                a = static_cast<T>(val);
+                b = mask;
+            }
+        }
+    };
+
+    template<typename T, Condition C>
+    bool isMatch(T curVal, T prevVal, const Operands<T>& op)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            if (C == COND_EQUALS)
+            {
+                return curVal >= op.low && curVal < op.high;
+            }
+        }
+        else
+        {
+            typedef std::make_unsigned_t<T> U;
+
+            switch (C)
+            {
+                case COND_EQUALS:       return curVal == op.val;
+                case COND_BETWEEN:      return curVal >= op.low && curVal <= op.high;
+                case COND_INCREASED_BY: return static_cast<U>(static_cast<U>(curVal) - static_cast<U>(prevVal))
+                                               == static_cast<U>(op.val);
+                case COND_DECREASED_BY: return static_cast<U>(static_cast<U>(prevVal) - static_cast<U>(curVal))
+                                               == static_cast<U>(op.val);
+                case COND_BITMASK:      return (curVal & op.mask) == static_cast<T>(op.val);
+                default:                break;
+            }
+        }
+        if (C == COND_INCREASED)
+        {
+            return curVal > prevVal;
+        }
+        if (C == COND_DECREASED)
+        {
+            return curVal < prevVal;
+        }
+        if (C == COND_CHANGED)
+        {
+            return curVal != prevVal;
+        }
+        return curVal == prevVal;
+    }
+
+    /**
+     * \brief Reference kernel. Aligned kernels have one mask bit per sizeof(T) bytes, unaligned ones one per byte.
+     */
+    template<typename T, Condition C, bool Aligned>
+    size_t filterScalar(const char* current, const char* previous, char* searchMask, size_t begin, size_t end,
+                        const Kernels::FilterArgs& args)
+    {
+        const size_t stride = Aligned ? sizeof(T) : 1;
+        const Operands<T> op(args);
+        size_t matches = 0;
+
+        for (size_t offset = begin; offset + sizeof(T) <= end; offset += stride)
+        {
+            size_t index = offset / stride;
+
+            if (searchMask[index/8] & (1<<(index%8)))
+            {
+                T curVal;
+                T prevVal;
+
+                std::memcpy(&curVal, current + (offset - begin), sizeof(T));
+                std::memcpy(&prevVal, previous + (offset - begin), sizeof(T));
+                if (isMatch<T, C>(curVal, prevVal, op))
+                {
+                    matches++;
+                }
+                else
+                {
+                    searchMask[index/8] &= ~(1<<(index%8));
+                }
+            }
+        }
+
+        return matches;
+    }
+
+#ifdef MEMSCAN_X86
+    /**
+     * \brief Operands broadcast to all lanes, see Operands::lanes
+     */
+    struct OperandsAvx2
+    {
+        __m256i a;
+        __m256i b;
+    };
+
+    template<typename T>
+    __attribute__((target("avx2"))) __m256i set1Avx2(T val)
+    {
+        if constexpr (std::is_same_v<T, float>) return _mm256_castps_si256(_mm256_set1_ps(val));
+        else if constexpr (std::is_same_v<T, double>) return _mm256_castpd_si256(_mm256_set1_pd(val));
+        else if constexpr (sizeof(T) == 1) return _mm256_set1_epi8(val);
+        else if constexpr (sizeof(T) == 2) return _mm256_set1_epi16(val);
+        else if constexpr (sizeof(T) == 4) return _mm256_set1_epi32(val);
+        else return _mm256_set1_epi64x(val);
+    }
+
+    template<typename T, Condition C>
+    __attribute__((target("avx2"))) OperandsAvx2 set1Avx2(const Operands<T>& op)
+    {
+        T a;
+        T b;
+
+        op.template lanes<C>(a, b);
+        return {set1Avx2<T>(a), set1Avx2<T>(b)};
+    }
+
+    template<typename T>
+    __attribute__((target("avx2"))) __m256i cmpeqAvx2(__m256i a, __m256i b)
+    {
+        if constexpr (sizeof(T) == 1) return _mm256_cmpeq_epi8(a, b);
+        else if constexpr (sizeof(T) == 2) return _mm256_cmpeq_epi16(a, b);
+        else if constexpr (sizeof(T) == 4) return _mm256_cmpeq_epi32(a, b);
+        else return _mm256_cmpeq_epi64(a, b);
+    }
+
+    template<typename T>
+    __attribute__((target("avx2"))) __m256i cmpgtAvx2(__m256i a, __m256i b)
+    {
+        if constexpr (sizeof(T) == 1) return _mm256_cmpgt_epi8(a, b);
+        else if constexpr (sizeof(T) == 2) return _mm256_cmpgt_epi16(a, b);
+        else if constexpr (sizeof(T) == 4) return _mm256_cmpgt_epi32(a, b);
+        else return _mm256_cmpgt_epi64(a, b);
+    }
+
+    template<typename T>
+    __attribute__((target("avx2"))) __m256i subAvx2(__m256i a, __m256i b)
+    {
+        if constexpr (sizeof(T) == 1) return _mm256_sub_epi8(a, b);
+        else if constexpr (sizeof(T) == 2) return _mm256_sub_epi16(a, b);
+        else if constexpr (sizeof(T) == 4) return _mm256_sub_epi32(a, b);
+        else return _mm256_sub_epi64(a, b);
+    }
+
+    /**
+     * \brief Compare 32 bytes of floats, lanes of matching elements are all ones
+     */
+    template<typename T, Condition C>
+    __attribute__((target("avx2"))) __m256i compareFloatAvx2(const char* current, const char* previous, 
+                                                             const OperandsAvx2& ops)
+    {
+        if constexpr (sizeof(T) == 4)
+        {
+            __m256 cur = _mm256_loadu_ps(reinterpret_cast<const float*>(current));
+
+            if (C == COND_EQUALS)
+            {
+                return _mm256_castps_si256(_mm256_and_ps(_mm256_cmp_ps(cur, _mm256_castsi256_ps(ops.a), _CMP_GE_OQ),
+                                                         _mm256_cmp_ps(cur, _mm256_castsi256_ps(ops.b), _CMP_LT_OQ)));
+            }
+
+            __m256 prev = _mm256_loadu_ps(reinterpret_cast<const float*>(previous));
+            return _mm256_castps_si256(_mm256_cmp_ps(cur, prev, (C == COND_INCREASED) ? _CMP_GT_OQ : _CMP_LT_OQ));
+        }
+        else
+        {
+            __m256d cur = _mm256_loadu_pd(reinterpret_cast<const double*>(current));
+
+            if (C == COND_EQUALS)
+            {
+                return _mm256_castpd_si256(_mm256_and_pd(_mm256_cmp_pd(cur, _mm256_castsi256_pd(ops.a), _CMP_GE_OQ),
+                                                         _mm256_cmp_pd(cur, _mm256_castsi256_pd(ops.b), _CMP_LT_OQ)));
+            }
+
+            __m256d prev = _mm256_loadu_pd(reinterpret_cast<const double*>(previous));
+            return _mm256_castpd_si256(_mm256_cmp_pd(cur, prev, (C == COND_INCREASED) ? _CMP_GT_OQ : _CMP_LT_OQ));
+        }
+    }
+
+    /**
+     * \brief Compare 32 bytes, lanes of matching elements are all ones
+     */
+    template<typename T, Condition C>
+    __attribute__((target("avx2"))) __m256i compareAvx2(const char* current, const char* previous, 
+                                                        const OperandsAvx2& ops)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            return compareFloatAvx2<T, C>(current, previous, ops);
+        }
+        else
+        {
+            __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current));
+
+            switch (C)
+            {
+                case COND_EQUALS:  return cmpeqAvx2<T>(cur, ops.a);
+                case COND_BETWEEN: return _mm256_xor_si256(_mm256_or_si256(cmpgtAvx2<T>(ops.a, cur), 
+                                                                           cmpgtAvx2<T>(cur, ops.b)),
+                                                           _mm256_set1_epi32(-1));
+                case COND_BITMASK: return cmpeqAvx2<T>(_mm256_and_si256(cur, ops.b), ops.a);
+                default:           break;
+            }
+
+            __m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(previous));
+            switch (C)
+            {
+                case COND_INCREASED:    return cmpgtAvx2<T>(cur, prev);
+                case COND_DECREASED:    return cmpgtAvx2<T>(prev, cur);
+                case COND_CHANGED:      return _mm256_xor_si256(cmpeqAvx2<T>(cur, prev), _mm256_set1_epi32(-1));
+                case COND_INCREASED_BY: return cmpeqAvx2<T>(subAvx2<T>(cur, prev), ops.a);
+                case COND_DECREASED_BY: return cmpeqAvx2<T>(subAvx2<T>(prev, cur), ops.a);
+                default:                return cmpeqAvx2<T>(cur, prev);
+            }
+        }
+    }
+
+    /**
+     * \brief Compare 32 consecutive aligned elements (32*sizeof(T) bytes) and pack the result into one bit per element
+     */
+    template<typename T, Condition C>
+    __attribute__((target("avx2"))) uint32_t elementBitsAvx2(const char* current, const char* previous, const OperandsAvx2& ops)
+    {
+        if constexpr (sizeof(T) == 1)
+        {
+            return _mm256_movemask_epi8(compareAvx2<T, C>(current, previous, ops));
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            __m256i packed = _mm256_packs_epi16(compareAvx2<T, C>(current, previous, ops),
+                                                compareAvx2<T, C>(current + 32, previous + 32, ops));
+            return _mm256_movemask_epi8(_mm256_permute4x64_epi64(packed, 0xd8));
+        }
+        else
+        {
+            uint32_t bits = 0;
+
+            for (int v = 0; v < static_cast<int>(sizeof(T)); v++)
+            {
+                __m256i cmp = compareAvx2<T, C>(current + 32*v, previous + 32*v, ops);
+                if constexpr (sizeof(T) == 4)
+                {
+                    bits |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(cmp))) << 8*v;
+                }
+                else
+                {
+                    bits |= static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(cmp))) << 4*v;
+                }
+            }
+
+            return bits;
+        }
+    }
+
+    /**
+     * \brief Compare the elements starting at each of 32 consecutive bytes. Every phase of sizeof(T) loads yields the
+     * element starts at its own byte positions.
+     */
+    template<typename T, Condition C>
+    __attribute__((target("avx2"))) uint32_t byteBitsAvx2(const char* current, const char* previous, const OperandsAvx2& ops)
+    {
+        uint32_t bits = 0;
+
+        for (int phase = 0; phase < static_cast<int>(sizeof(T)); phase++)
+        {
+            __m256i cmp = compareAvx2<T, C>(current + phase, previous + phase, ops);
+            bits |= (static_cast<uint32_t>(_mm256_movemask_epi8(cmp)) & strideBits<T>()) << phase;
+        }
+
+        return bits;
+    }
+
+    template<typename T, Condition C, bool Aligned>
+    __attribute__((target("avx2")))
+    size_t filterAvx2(const char* current, const char* previous, char* searchMask, size_t begin, size_t end,
+                      const Kernels::FilterArgs& args)
+    {
+        if constexpr (!std::is_floating_point_v<T>)
+        {
+            if (C == COND_EQUALS && !fitsType<T>(args.val))
+            {
+                return filterScalar<T, C, Aligned>(current, previous, searchMask, begin, end, args);
+            }
+        }
+
+        const size_t stride = Aligned ? sizeof(T) : 1;
+        const size_t groupBytes = 32 * stride;
+        const size_t readBytes = Aligned ? groupBytes : groupBytes + sizeof(T) - 1;
+        const OperandsAvx2 ops = set1Avx2<T, C>(Operands<T>(args));
+        size_t matches = 0;
+        size_t offset = begin;
+
+        for (; offset + readBytes <= end; offset += groupBytes)
+        {
+            char* maskWordPtr = searchMask + offset/stride/8;
+            uint32_t maskWord;
+
+            std::memcpy(&maskWord, maskWordPtr, 4);
+            if (maskWord == 0)
+            {
+                continue;
+            }
+
+            if (Aligned)
+            {
+                maskWord &= elementBitsAvx2<T, C>(current + (offset - begin), previous + (offset - begin), ops);
+            }
+            else
+            {
+                maskWord &= byteBitsAvx2<T, C>(current + (offset - begin), previous + (offset - begin), ops);
+            }
+            std::memcpy(maskWordPtr, &maskWord, 4);
+            matches += __builtin_popcount(maskWord);
+        }
+
+        return matches + filterScalar<T, C, Aligned>(current + (offset - begin), previous + (offset - begin), searchMask,
+                                                     offset, end, args);
+    }
+
+    struct OperandsSse
+    {
+        __m128i a;
+        __m128i b;
+    };
+
+    template<typename T>
+    __attribute__((target("sse4.2"))) __m128i set1Sse(T val)
+    {
+        if constexpr (std::is_same_v<T, float>) return _mm_castps_si128(_mm_set1_ps(val));
+        else if constexpr (std::is_same_v<T, double>) return _mm_castpd_si128(_mm_set1_pd(val));
+        else if constexpr (sizeof(T) == 1) return _mm_set1_epi8(val);
+        else if constexpr (sizeof(T) == 2) return _mm_set1_epi16(val);
+        else if constexpr (sizeof(T) == 4) return _mm_set1_epi32(val);
+        else return _mm_set1_epi64x(val);
+    }
+
+    template<typename T, Condition C>
+    __attribute__((target("sse4.2"))) OperandsSse set1Sse(const Operands<T>& op)
+    {
+        T a;
+        T b;
+
+        op.template lanes<C>(a, b);
+        return {set1Sse<T>(a), set1Sse<T>(b)};
+    }
+
+    template<typename T>
+    __attribute__((target("sse4.2"))) __m128i cmpeqSse(__m128i a, __m128i b)
+    {
+        if constexpr (sizeof(T) == 1) return _mm_cmpeq_epi8(a, b);
+        else if constexpr (sizeof(T) == 2) return _mm_cmpeq_epi16(a, b);
+        else if constexpr (sizeof(T) == 4) return _mm_cmpeq_epi32(a, b);
+        else return _mm_cmpeq_epi64(a, b);
+    }
+
+    template<typename T>
+    __attribute__((target("sse4.2"))) __m128i cmpgtSse(__m128i a, __m128i b)
+    {
+        if constexpr (sizeof(T) == 1) return _mm_cmpgt_epi8(a, b);
+        else if constexpr (sizeof(T) == 2) return _mm_cmpgt_epi16(a, b);
+        else if constexpr (sizeof(T) == 4) return _mm_cmpgt_epi32(a, b);
+        else return _mm_cmpgt_epi64(a, b);
+    }
+
+    template<typename T>
+    __attribute__((target("sse4.2"))) __m128i subSse(__m128i a, __m128i b)
+    {
+        if constexpr (sizeof(T) == 1) return _mm_sub_epi8(a, b);
+        else if constexpr (sizeof(T) == 2) return _mm_sub_epi16(a, b);
+        else if constexpr (sizeof(T) == 4) return _mm_sub_epi32(a, b);
+        else return _mm_sub_epi64(a, b);
+    }
+
+    /**
+     * \brief Compare 16 bytes of floats, lanes of matching elements are all ones
+     */
+    template<typename T, Condition C>
+    __attribute__((target("sse4.2"))) __m128i compareFloatSse(const char* current, const char* previous, 
+                                                              const OperandsSse& ops)
+    {
+        if constexpr (sizeof(T) == 4)
+        {
+            __m128 cur = _mm_loadu_ps(reinterpret_cast<const float*>(current));
+
+            if (C == COND_EQUALS)
+            {
+                return _mm_castps_si128(_mm_and_ps(_mm_cmpge_ps(cur, _mm_castsi128_ps(ops.a)),
+                                                   _mm_cmplt_ps(cur, _mm_castsi128_ps(ops.b))));
+            }
+
+            __m128 prev = _mm_loadu_ps(reinterpret_cast<const float*>(previous));
+            return _mm_castps_si128((C == COND_INCREASED) ? _mm_cmpgt_ps(cur, prev) : _mm_cmplt_ps(cur, prev));
+        }
+        else
+        {
+            __m128d cur = _mm_loadu_pd(reinterpret_cast<const double*>(current));
+
+            if (C == COND_EQUALS)
+            {
+                return _mm_castpd_si128(_mm_and_pd(_mm_cmpge_pd(cur, _mm_castsi128_pd(ops.a)),
+                                                   _mm_cmplt_pd(cur, _mm_castsi128_pd(ops.b))));
+            }
+
+            __m128d prev = _mm_loadu_pd(reinterpret_cast<const double*>(previous));
+            return _mm_castpd_si128((C == COND_INCREASED) ? _mm_cmpgt_pd(cur, prev) : _mm_cmplt_pd(cur, prev));
+        }
+    }
+
+    /**
+     * \brief Compare 16 bytes, lanes of matching elements are all ones
+     */
+    template<typename T, Condition C>
+    __attribute__((target("sse4.2"))) __m128i compareSse(const char* current, const char* previous, 
+                                                         const OperandsSse& ops)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            return compareFloatSse<T, C>(current, previous, ops);
+        }
+        else
+        {
+            __m128i cur = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+
+            switch (C)
+            {
+                case COND_EQUALS:  return cmpeqSse<T>(cur, ops.a);
+                case COND_BETWEEN: return _mm_xor_si128(_mm_or_si128(cmpgtSse<T>(ops.a, cur), cmpgtSse<T>(cur, ops.b)),
+                                                        _mm_set1_epi32(-1));
+                case COND_BITMASK: return cmpeqSse<T>(_mm_and_si128(cur, ops.b), ops.a);
+                default:           break;
+            }
+
+            __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previous));
+            switch (C)
+            {
+                case COND_INCREASED:    return cmpgtSse<T>(cur, prev);
+                case COND_DECREASED:    return cmpgtSse<T>(prev, cur);
+                case COND_CHANGED:      return _mm_xor_si128(cmpeqSse<T>(cur, prev), _mm_set1_epi32(-1));
+                case COND_INCREASED_BY: return cmpeqSse<T>(subSse<T>(cur, prev), ops.a);
+                case COND_DECREASED_BY: return cmpeqSse<T>(subSse<T>(prev, cur), ops.a);
+                default:                return cmpeqSse<T>(cur, prev);
+            }
+        }
+    }
+
+    /**
+     * \brief Compare 32 consecutive aligned elements (32*sizeof(T) bytes) and pack the result into one bit per element
+     */
+    template<typename T, Condition C>
+    __attribute__((target("sse4.2"))) uint32_t elementBitsSse(const char* current, const char* previous, const OperandsSse& ops)
+    {
+        uint32_t bits = 0;
+
+        if constexpr (sizeof(T) == 1)
+        {
+            for (int v = 0; v < 2; v++)
+            {
+                __m128i cmp = compareSse<T, C>(current + 16*v, previous + 16*v, ops);
+                bits |= static_cast<uint32_t>(_mm_movemask_epi8(cmp)) << 16*v;
+            }
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            for (int v = 0; v < 2; v++)
+            {
+                __m128i packed = _mm_packs_epi16(compareSse<T, C>(current + 32*v, previous + 32*v, ops),
+                                                 compareSse<T, C>(current + 32*v + 16, previous + 32*v + 16, ops));
+                bits |= static_cast<uint32_t>(_mm_movemask_epi8(packed)) << 16*v;
+            }
+        }
+        else
+        {
+            for (int v = 0; v < 2*static_cast<int>(sizeof(T)); v++)
+            {
+                __m128i cmp = compareSse<T, C>(current + 16*v, previous + 16*v, ops);
+                if constexpr (sizeof(T) == 4)
+                {
+                    bits |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(cmp))) << 4*v;
+                }
+                else
+                {
+                    bits |= static_cast<uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(cmp))) << 2*v;
+                }
+            }
+        }
+
+        return bits;
+    }
+
+    /**
+     * \brief Compare the elements starting at each of 32 consecutive bytes
+     */
+    template<typename T, Condition C>
+    __attribute__((target("sse4.2"))) uint32_t byteBitsSse(const char* current, const char* previous, const OperandsSse& ops)
+    {
+        uint32_t bits = 0;
+
+        for (int phase = 0; phase < static_cast<int>(sizeof(T)); phase++)
+        {
+            uint32_t cmpBits = 0;
+
+            for (int v = 0; v < 2; v++)
+            {
+                __m128i cmp = compareSse<T, C>(current + phase + 16*v, previous + phase + 16*v, ops);
+                cmpBits |= static_cast<uint32_t>(_mm_movemask_epi8(cmp)) << 16*v;
+            }
+            bits |= (cmpBits & strideBits<T>()) << phase;
+        }
+
+        return bits;
+    }
+
+    template<typename T, Condition C, bool Aligned>
+    __attribute__((target("sse4.2")))
+    size_t filterSse42(const char* current, const char* previous, char* searchMask, size_t begin, size_t end,
+                       const Kernels::FilterArgs& args)
+    {
+        if constexpr (!std::is_floating_point_v<T>)
+        {
+            if (C == COND_EQUALS && !fitsType<T>(args.val))
+            {
+                return filterScalar<T, C, Aligned>(current, previous, searchMask, begin, end, args);
+            }
+        }
+
+        const size_t stride = Aligned ? sizeof(T) : 1;
+        const size_t groupBytes = 32 * stride;
+        const size_t readBytes = Aligned ? groupBytes : groupBytes + sizeof(T) - 1;
+        const OperandsSse ops = set1Sse<T, C>(Operands<T>(args));
+        size_t matches = 0;
+        size_t offset = begin;
+
+        for (; offset + readBytes <= end; offset += groupBytes)
+        {
+            char* maskWordPtr = searchMask + offset/stride/8;
+            uint32_t maskWord;
+
+            std::memcpy(&maskWord, maskWordPtr, 4);
+            if (maskWord == 0)
+            {
+                continue;
+            }
+
+            if (Aligned)
+            {
+                maskWord &= elementBitsSse<T, C>(current + (offset - begin), previous + (offset - begin), ops);
+            }
+            else
+            {
+                maskWord &= byteBitsSse<T, C>(current + (offset - begin), previous + (offset - begin), ops);
+            }
+            std::memcpy(maskWordPtr, &maskWord, 4);
+            matches += __builtin_popcount(maskWord);
+        }
+
+        return matches + filterScalar<T, C, Aligned>(current + (offset - begin), previous + (offset - begin), searchMask,
+                                                     offset, end, args);
+    }
+#endif
+
+    /**
+     * \brief ASCII upper case letters to lower case, everything else unchanged
+     */
+    inline char foldCase(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? c | 0x20 : c;
+    }
+
+    /**
+     * \brief Compare the string at data with val. Wide strings compare UTF-16 code units, so that only code units
+     * below 0x80 are case folded. val is case folded already.
+     */
+    template<bool Wide, bool IgnoreCase>
+    bool stringAt(const char* data, const char* val, size_t valSize)
+    {
+        if (!IgnoreCase)
+        {
+            return std::memcmp(data, val, valSize) == 0;
+        }
+
+        for (size_t i = 0; i < valSize; i += Wide ? 2 : 1)
+        {
+            if (Wide)
+            {
+                char low = (data[i+1] == 0) ? foldCase(data[i]) : data[i];
+
+                if (low != val[i] || data[i+1] != val[i+1])
+                {
+                    return false;
+                }
+            }
+            else if (foldCase(data[i]) != val[i])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * \brief Reference string kernel, one mask bit per byte. Mask bytes without bits are skipped 8 offsets at a time, 
+     * wide strings only start at even offsets.
+     */
+    template<bool Wide, bool IgnoreCase>
+    size_t filterStringScalar(const char* data, char* searchMask, size_t begin, size_t end, size_t limit,
+                              const char* val, size_t valSize)
+    {
+        size_t matches = 0;
+
+        for (size_t offset = begin; offset < end; offset++)
+        {
+            if (offset % 8 == 0 && searchMask[offset/8] == 0)
+            {
+                offset += 7;
+                continue;
+            }
+            if (!(searchMask[offset/8] & (1<<(offset%8))))
+            {
+                continue;
+            }
+
+            if ((!Wide || offset % 2 == 0) && offset + valSize <= limit
+                && stringAt<Wide, IgnoreCase>(data + (offset - begin), val, valSize))
+            {
+                matches++;
+            }
+            else
+            {
+                searchMask[offset/8] &= ~(1<<(offset%8));
+            }
+        }
+
+        return matches;
+    }
+
+    /**
+     * \brief Check the candidates of a mask word, those whose first and last byte already matched
+     */
+    template<bool Wide, bool IgnoreCase>
+    uint32_t verifyCandidates(const char* data, uint32_t candidates, const char* val, size_t valSize)
+    {
+        uint32_t found = 0;
+
+        if (Wide)
+        {
+            candidates &= 0x55555555;
+        }
+        while (candidates != 0)
+        {
+            int i = __builtin_ctz(candidates);
+
+            if (IgnoreCase ? stringAt<Wide, IgnoreCase>(data + i, val, valSize)
+                           : valSize <= 2 || std::memcmp(data + i + 1, val + 1, valSize - 2) == 0)
+            {
+                found |= 1u << i;
+            }
+            candidates &= candidates - 1;
+        }
+
+        return found;
+    }
+
+#ifdef MEMSCAN_X86
+    /**
+     * \brief Load 32 bytes, with ASCII upper case letters folded to lower case if IgnoreCase. Folding every byte, even 
+     * those of non-ASCII code units, only lets through more candidates, the verify step is exact.
+     */
+    template<bool IgnoreCase>
+    __attribute__((target("avx2"))) __m256i loadFoldedAvx2(const char* data)
+    {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+
+        if (IgnoreCase)
+        {
+            __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8('A' - 1)),
+                                             _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), bytes));
+            bytes = _mm256_or_si256(bytes, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+        }
+
+        return bytes;
+    }
+
+    /**
+     * \brief Compare first and last byte of val at 32 offsets at once, only offsets that pass both are compared fully
+     */
+    template<bool Wide, bool IgnoreCase>
+    __attribute__((target("avx2")))
+    size_t filterStringAvx2(const char* data, char* searchMask, size_t begin, size_t end, size_t limit,
+                            const char* val, size_t valSize)
+    {
+        const __m256i first = _mm256_set1_epi8(IgnoreCase ? foldCase(val[0]) : val[0]);
+        const __m256i last = _mm256_set1_epi8(IgnoreCase ? foldCase(val[valSize-1]) : val[valSize-1]);
+        size_t matches = 0;
+        size_t offset = begin;
+
+        for (; offset + 32 <= end && offset + 32 + valSize - 1 <= limit; offset += 32)
+        {
+            const char* cur = data + (offset - begin);
+            char* maskWordPtr = searchMask + offset/8;
+            uint32_t maskWord;
+
+            std::memcpy(&maskWord, maskWordPtr, 4);
+            if (maskWord == 0)
+            {
+                continue;
+            }
+
+            __m256i eqFirst = _mm256_cmpeq_epi8(loadFoldedAvx2<IgnoreCase>(cur), first);
+            __m256i eqLast = _mm256_cmpeq_epi8(loadFoldedAvx2<IgnoreCase>(cur + valSize - 1), last);
+            uint32_t candidates = maskWord & _mm256_movemask_epi8(_mm256_and_si256(eqFirst, eqLast));
+
+            maskWord = verifyCandidates<Wide, IgnoreCase>(cur, candidates, val, valSize);
+            std::memcpy(maskWordPtr, &maskWord, 4);
+            matches += __builtin_popcount(maskWord);
+        }
+
+        return matches + filterStringScalar<Wide, IgnoreCase>(data + (offset - begin), searchMask, offset, end, limit,
+                                                              val, valSize);
+    }
+
+    template<bool IgnoreCase>
+    __attribute__((target("sse4.2"))) __m128i loadFoldedSse(const char* data)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+
+        if (IgnoreCase)
+        {
+            __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('A' - 1)),
+                                          _mm_cmplt_epi8(bytes, _mm_set1_epi8('Z' + 1)));
+            bytes = _mm_or_si128(bytes, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+        }
+
+        return bytes;
+    }
+
+    template<bool Wide, bool IgnoreCase>
+    __attribute__((target("sse4.2")))
+    size_t filterStringSse42(const char* data, char* searchMask, size_t begin, size_t end, size_t limit,
+                             const char* val, size_t valSize)
+    {
+        const __m128i first = _mm_set1_epi8(IgnoreCase ? foldCase(val[0]) : val[0]);
+        const __m128i last = _mm_set1_epi8(IgnoreCase ? foldCase(val[valSize-1]) : val[valSize-1]);
+        size_t matches = 0;
+        size_t offset = begin;
+
+        for (; offset + 32 <= end && offset + 32 + valSize - 1 <= limit; offset += 32)
+        {
+            const char* cur = data + (offset - begin);
+            char* maskWordPtr = searchMask + offset/8;
+            uint32_t maskWord;
+            uint32_t eqBits = 0;
+
+            std::memcpy(&maskWord, maskWordPtr, 4);
+            if (maskWord == 0)
+            {
+                continue;
+            }
+
+            for (int v = 0; v < 2; v++)
+            {
+                const char* half = cur + 16*v;
+                __m128i eqFirst = _mm_cmpeq_epi8(loadFoldedSse<IgnoreCase>(half), first);
+                __m128i eqLast = _mm_cmpeq_epi8(loadFoldedSse<IgnoreCase>(half + valSize - 1), last);
+                eqBits |= static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(eqFirst, eqLast))) << 16*v;
+            }
+
+            maskWord = verifyCandidates<Wide, IgnoreCase>(cur, maskWord & eqBits, val, valSize);
+            std::memcpy(maskWordPtr, &maskWord, 4);
+            matches += __builtin_popcount(maskWord);
+        }
+
+        return matches + filterStringScalar<Wide, IgnoreCase>(data + (offset - begin), searchMask, offset, end, limit,
+                                                              val, valSize);
+    }
+#endif
+
+    template<bool Wide, bool IgnoreCase>
+    Kernels::StringFilter pickStringKernel()
+    {
+#ifdef MEMSCAN_X86
+        switch (Kernels::instructionSet())
+        {
+            case ISA_AVX2:  return filterStringAvx2<Wide, IgnoreCase>;
+            case ISA_SSE42: return filterStringSse42<Wide, IgnoreCase>;
+            default:        break;
+        }
+#endif
+        return filterStringScalar<Wide, IgnoreCase>;
+    }
+
+    /**
+     * \brief Compare a pattern with the window at data, 8 bytes at a time
+     */
+    bool patternAt(const char* data, const Kernels::PatternArgs& pattern)
+    {
+        size_t i = 0;
+
+        for (; i + 8 <= pattern.size; i += 8)
+        {
+            uint64_t window;
+            uint64_t bytes;
+            uint64_t mask;
+
+            std::memcpy(&window, data + i, 8);
+            std::memcpy(&bytes, pattern.bytes + i, 8);
+            std::memcpy(&mask, pattern.mask + i, 8);
+            if ((window ^ bytes) & mask)
+            {
+                return false;
+            }
+        }
+        for (; i < pattern.size; i++)
+        {
+            if ((data[i] ^ pattern.bytes[i]) & pattern.mask[i])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * \brief Reference pattern kernel. After each window the search moves on by the skip of the window's last byte,
+     * the offsets in between can't match and leave the search.
+     */
+    size_t filterPatternScalar(const char* data, char* searchMask, size_t begin, size_t end, size_t limit,
+                               const Kernels::PatternArgs& pattern)
+    {
+        size_t matches = 0;
+        size_t offset = begin;
+
+        while (offset < end)
+        {
+            if (offset % 8 == 0 && searchMask[offset/8] == 0)
+            {
+                offset += 8;
+                continue;
+            }
+            if (offset + pattern.size > limit)
+            {
+                searchMask[offset/8] &= ~(1<<(offset%8));
+                offset++;
+                continue;
+            }
+
+            const char* window = data + (offset - begin);
+            size_t shift = pattern.skip[static_cast<unsigned char>(window[pattern.size-1])];
+
+            if ((searchMask[offset/8] & (1<<(offset%8))) && patternAt(window, pattern))
+            {
+                matches++;
+            }
+            else
+            {
+                searchMask[offset/8] &= ~(1<<(offset%8));
+            }
+            for (size_t skipped = offset + 1; skipped < std::min(offset + shift, end); skipped++)
+            {
+                searchMask[skipped/8] &= ~(1<<(skipped%8));
+            }
+            offset += shift;
+        }
+
+        return matches;
+    }
+
+#ifdef MEMSCAN_X86
+    __attribute__((target("avx2")))
+    size_t filterPatternAvx2(const char* data, char* searchMask, size_t begin, size_t end, size_t limit,
+                             const Kernels::PatternArgs& pattern)
+    {
+        const __m256i anchor = _mm256_set1_epi8(pattern.bytes[pattern.anchor]);
+        const __m256i last = _mm256_set1_epi8(pattern.bytes[pattern.last]);
+        size_t matches = 0;
+        size_t offset = begin;
+
+        for (; offset + 32 <= end && offset + 32 + pattern.size - 1 <= limit; offset += 32)
+        {
+            const char* cur = data + (offset - begin);
+            char* maskWordPtr = searchMask + offset/8;
+            uint32_t maskWord;
+            uint32_t found = 0;
+
+            std::memcpy(&maskWord, maskWordPtr, 4);
+            if (maskWord == 0)
+            {
+                continue;
+            }
+
+            __m256i eqAnchor = _mm256_cmpeq_epi8(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cur + pattern.anchor)), anchor);
+            __m256i eqLast = _mm256_cmpeq_epi8(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cur + pattern.last)), last);
+            uint32_t candidates = maskWord & _mm256_movemask_epi8(_mm256_and_si256(eqAnchor, eqLast));
+
+            while (candidates != 0)
+            {
+                int i = __builtin_ctz(candidates);
+
+                if (patternAt(cur + i, pattern))
+                {
+                    found |= 1u << i;
+                }
+                candidates &= candidates - 1;
+            }
+            std::memcpy(maskWordPtr, &found, 4);
+            matches += __builtin_popcount(found);
+        }
+
+        return matches + filterPatternScalar(data + (offset - begin), searchMask, offset, end, limit, pattern);
+    }
+
+    __attribute__((target("sse4.2")))
+    size_t filterPatternSse42(const char* data, char* searchMask, size_t begin, size_t end, size_t limit,
+                              const Kernels::PatternArgs& pattern)
+    {
+        const __m128i anchor = _mm_set1_epi8(pattern.bytes[pattern.anchor]);
+        const __m128i last = _mm_set1_epi8(pattern.bytes[pattern.last]);
+        size_t matches = 0;
+        size_t offset = begin;
+
+        for (; offset + 32 <= end && offset + 32 + pattern.size - 1 <= limit; offset += 32)
+        {
+            const char* cur = data + (offset - begin);
+            char* maskWordPtr = searchMask + offset/8;
+            uint32_t maskWord;
+            uint32_t candidates = 0;
+            uint32_t found = 0;
+
+            std::memcpy(&maskWord, maskWordPtr, 4);
+            if (maskWord == 0)
+            {
+                continue;
+            }
+
+            for (int v = 0; v < 2; v++)
+            {
+                const char* half = cur + 16*v;
+                __m128i eqAnchor = _mm_cmpeq_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(half + pattern.anchor)), anchor);
+                __m128i eqLast = _mm_cmpeq_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(half + pattern.last)), last);
+                candidates |= static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(eqAnchor, eqLast))) << 16*v;
+            }
+            candidates &= maskWord;
+
+            while (candidates != 0)
+            {
+                int i = __builtin_ctz(candidates);
+
+                if (patternAt(cur + i, pattern))
+                {
+                    found |= 1u << i;
+                }
+                candidates &= candidates - 1;
+            }
+            std::memcpy(maskWordPtr, &found, 4);
+            matches += __builtin_popcount(found);
+        }
+
+        return matches + filterPatternScalar(data + (offset - begin), searchMask, offset, end, limit, pattern);
+    }
+#endif
+
+    template<typename T, Condition C, bool Aligned>
+    Kernels::Filter pickKernel()
+    {
+#ifdef MEMSCAN_X86
+        switch (Kernels::instructionSet())
+        {
+            case ISA_AVX2:  return filterAvx2<T, C, Aligned>;
+            case ISA_SSE42: return filterSse42<T, C, Aligned>;
+            default:        break;
+        }
+#endif
+        return filterScalar<T, C, Aligned>;
+    }
+
+    template<typename T, bool Aligned>
+    Kernels::Filter pickFilter(Condition condition)
+    {
+        if constexpr (std::is_integral_v<T>)
+        {
+            switch (condition)
+            {
+                case COND_BETWEEN:      return pickKernel<T, COND_BETWEEN, Aligned>();
+                case COND_INCREASED_BY: return pickKernel<T, COND_INCREASED_BY, Aligned>();
+                case COND_DECREASED_BY: return pickKernel<T, COND_DECREASED_BY, Aligned>();
+                case COND_BITMASK:      return pickKernel<T, COND_BITMASK, Aligned>();
+                default:                break;
+            }
+        }
+
+        switch (condition)
+        {
+            case COND_EQUALS:    return pickKernel<T, COND_EQUALS, Aligned>();
+            case COND_INCREASED: return pickKernel<T, COND_INCREASED, Aligned>();
+            case COND_DECREASED: return pickKernel<T, COND_DECREASED, Aligned>();
+            case COND_CHANGED:   return pickKernel<T, COND_CHANGED, Aligned>();
+            case COND_UNCHANGED: return pickKernel<T, COND_UNCHANGED, Aligned>();
+            default:             return nullptr;
+        }
+    }
+
+    template<typename T>
+    Kernels::Filter pickFilter(Condition condition, bool aligned)
+    {
+        return aligned ? pickFilter<T, true>(condition) : pickFilter<T, false>(condition);
+    }
+}
+
+/**
+ * \brief Best instruction set supported by this CPU and allowed by limitInstructionSet. Detected once.
+ */
+InstructionSet Kernels::instructionSet()
+{
+    static const InstructionSet detected = []
+    {
+#ifdef MEMSCAN_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return ISA_AVX2;
+        }
+        if (__builtin_cpu_supports("sse4.2"))
+        {
+            return ISA_SSE42;
+        }
+#endif
+        return ISA_SCALAR;
+    }();
+
+    return std::min(detected, isaLimit.load());
+}
+
+/**
+ * \brief Pick kernels of at most limit from now on, e.g. to compare the kernels of every instruction set. Kernels
+ * picked before keep theirs.
+ */
+void Kernels::limitInstructionSet(InstructionSet limit)
+{
+    isaLimit = limit;
+}
+
+/**
+ * \brief Get the filter kernel for given integer size and condition
+ * \param aligned True if mask has one bit per dataSize bytes, false if one bit per byte
+ * \return Kernel, or nullptr for COND_UNCONDITIONAL
+ */
+Kernels::Filter Kernels::intFilter(int dataSize, Condition condition, bool aligned)
+{
+    switch (dataSize)
+    {
+        case 1:
+            return pickFilter<int8_t>(condition, aligned);
+        case 2:
+            return pickFilter<int16_t>(condition, aligned);
+        case 4:
+        default:
+            return pickFilter<int32_t>(condition, aligned);
+        case 8:
+            return pickFilter<int64_t>(condition, aligned);
+    }
+}
+
+/**
+ * \brief Get the filter kernel for float (dataSize 4) or double (dataSize 8) values. COND_CHANGED and COND_UNCHANGED 
+ * compare the bits, they are the integer kernels of the same size. COND_BETWEEN is COND_EQUALS, whose [low, high) is
+ * a range already.
+ * \param aligned True if mask has one bit per dataSize bytes, false if one bit per byte
+ * \return Kernel, or nullptr for COND_UNCONDITIONAL and the integer-only conditions
+ */
+Kernels::Filter Kernels::floatFilter(int dataSize, Condition condition, bool aligned)
+{
+    if (condition == COND_BETWEEN)
+    {
+        condition = COND_EQUALS;
+    }
+    if (condition == COND_CHANGED || condition == COND_UNCHANGED)
+    {
+        return intFilter(dataSize, condition, aligned);
+    }
+
+    return (dataSize == 8) ? pickFilter<double>(condition, aligned) : pickFilter<float>(condition, aligned);
+}
+
+/**
+ * \brief Get the kernel that keeps the offsets where val starts
+ * \param encoding ENC_UTF16LE strings only start at even offsets and are case folded per code unit
+ * \param ignoreCase True if val is case folded already and ASCII letters match regardless of case
+ */
+Kernels::StringFilter Kernels::stringFilter(StringEncoding encoding, bool ignoreCase)
+{
+    if (encoding == ENC_UTF16LE)
+    {
+        return ignoreCase ? pickStringKernel<true, true>() : pickStringKernel<true, false>();
+    }
+
+    return ignoreCase ? pickStringKernel<false, true>() : pickStringKernel<false, false>();
+}
+
+/**
+ * \brief Get the kernel that keeps the offsets where a compiled byte pattern starts
+ */
+Kernels::PatternFilter Kernels::patternFilter()
+{
+#ifdef MEMSCAN_X86
+    switch (instructionSet())
+    {
+        case ISA_AVX2:  return filterPatternAvx2;
+        case ISA_SSE42: return filterPatternSse42;
+        default:        break;
+    }
+#endif
+    return filterPatternScalar;
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+#include "memblock.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+enum InstructionSet
+{
+    ISA_SCALAR,
+    ISA_SSE42,
+    ISA_AVX2
+};
+
+enum StringEncoding
+{
+    ENC_UTF8,
+    ENC_UTF16LE
+};
+
+/**
+ * \brief Filter kernels for the hot loops of the scanners, picked once at runtime by CPUID.
+ *
+ * Kernels compare 32 bytes of the new snapshot at a time, turn the result into a bitmask laid out like
+ * MemBlock's search mask and AND it into the mask a 32-bit word (32 elements) at a time. Aligned kernels expect one
+ * mask bit per dataSize bytes, unaligned ones a bit per byte. Ranges must start at the first byte of a mask word,
+ * the tail that doesn't fill a whole word is done by the scalar kernel.
+ */
+class Kernels
+{
+    public:
+        /**
+         * \brief Operands of a filter. Integer kernels compare with val, or take values in [val, val2] for 
+         * COND_BETWEEN, a difference of val for COND_INCREASED_BY and COND_DECREASED_BY and (value & val2) == val for
+         * COND_BITMASK. Float kernels take values in [low, high) as equal.
+         */
+        struct FilterArgs
+        {
+            int64_t val;
+            int64_t val2;
+            double low;
+            double high;
+        };
+
+        /**
+         * \brief Compiled byte pattern. Bytes whose mask byte is 0 are wildcards. The SIMD kernels look for the anchor
+         * byte and the last fixed byte 32 offsets at a time, the scalar kernel moves on by skip[last byte of the 
+         * window] offsets like Boyer-Moore-Horspool.
+         */
+        struct PatternArgs
+        {
+            const char* bytes;
+            const char* mask;
+            size_t size;
+            size_t anchor;
+            size_t last;
+            const size_t* skip;
+        };
+
+        /**
+         * \param current New values, starting at byte begin of the block
+         * \param previous Previous values, starting at byte begin of the block
+         * \param searchMask Search mask of the block
+         * \param begin First byte offset to filter
+         * \param end Byte offset after the last element to filter
+         * \param args Operands of the condition
+         * \return Number of elements left in search
+         */
+        typedef size_t (*Filter)(const char* current, const char* previous, char* searchMask,
+                                 size_t begin, size_t end, const FilterArgs& args);
+
+        /**
+         * \brief Keep the offsets in [begin, end) where the string val starts. The mask has one bit per byte. A first
+         * and last byte compare picks the candidates 32 offsets at a time, only those are compared in full.
+         * \param data Memory of the block, starting at byte begin
+         * \param limit Byte offset after the last readable byte of data, strings must end before it
+         * \param valSize Size of val, at least 1
+         * \return Number of offsets left in search
+         */
+        typedef size_t (*StringFilter)(const char* data, char* searchMask, size_t begin, size_t end, size_t limit,
+                                       const char* val, size_t valSize);
+
+        /**
+         * \brief Keep the offsets in [begin, end) where pattern starts. The mask has one bit per byte.
+         * \param data Memory of the block, starting at byte begin
+         * \param limit Byte offset after the last readable byte of data, matches must end before it
+         * \return Number of offsets left in search
+         */
+        typedef size_t (*PatternFilter)(const char* data, char* searchMask, size_t begin, size_t end, size_t limit,
+                                        const PatternArgs& pattern);
+
+        static Filter intFilter(int dataSize, Condition condition, bool aligned);
+        static Filter floatFilter(int dataSize, Condition condition, bool aligned);
+        static StringFilter stringFilter(StringEncoding encoding, bool ignoreCase);
+        static PatternFilter patternFilter();
+        static InstructionSet instructionSet();
+        static void limitInstructionSet(InstructionSet limit);
+};
\ No newline at end of file
@@ -0,0 +1,349 @@
+#include "floatscanner.hpp"
+#include "intscanner.hpp"
+#include "libmemscan.h"
+#include "process.hpp"
+#include "regionfilter.hpp"
+#include "scansession.hpp"
+#include "stringscanner.hpp"
+#include "threadpool.hpp"
+#include "valueset.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+static_assert(static_cast<int>(MEMSCAN_COND_BITMASK) == static_cast<int>(COND_BITMASK), 
+              "memscan_condition has to match Condition");
+static_assert(sizeof(memscan_sparse_match) == sizeof(SparseMatch) && 
+              offsetof(memscan_sparse_match, value) == offsetof(SparseMatch, value),
+              "memscan_sparse_match has to match SparseMatch");
+
+struct memscan_session
+{
+    std::shared_ptr<ScanSession> session;
+    ThreadPool pool;
+    int type;
+    bool ignoreCase;
+    // bytes passed to the match callback, the encoded size of the last string for string sessions
+    size_t valueSize;
+
+    memscan_session(std::shared_ptr<ScanSession> session, int threads, int type, bool ignoreCase)
+        : session(session)
+        , pool(threads)
+        , type(type)
+        , ignoreCase(ignoreCase)
+        , valueSize(session->dataSize())
+    {}
+};
+
+namespace
+{
+    /**
+     * \brief Run body and turn exceptions into status codes, they can't cross the C interface
+     */
+    template <typename Body>
+    int guard(Body body)
+    {
+        try
+        {
+            return body();
+        }
+        catch (const std::bad_alloc&)
+        {
+            return MEMSCAN_ERROR_MEMORY;
+        }
+        catch (...)
+        {
+            return MEMSCAN_ERROR_INTERNAL;
+        }
+    }
+}
+
+int memscan_abi_version(void)
+{
+    return MEMSCAN_ABI_VERSION;
+}
+
+const char* memscan_status_string(int status)
+{
+    switch (status)
+    {
+        case MEMSCAN_OK:
+            return "ok";
+        case MEMSCAN_ERROR_ARGUMENT:
+            return "invalid argument";
+        case MEMSCAN_ERROR_PROCESS:
+            return "process can't be opened or has no writable memory";
+        case MEMSCAN_ERROR_MEMORY:
+            return "out of memory";
+        case MEMSCAN_ERROR_INTERNAL:
+            return "internal error";
+    }
+
+    return "unknown status";
+}
+
+int memscan_open(int process_id, int type, int data_size, unsigned flags, int threads, memscan_session** session)
+{
+    return memscan_open_filtered(process_id, type, data_size, flags, threads, "", session);
+}
+
+int memscan_open_filtered(int process_id, int type, int data_size, unsigned flags, int threads, const char* regions,
+                          memscan_session** session)
+{
+    bool isString = type == MEMSCAN_TYPE_UTF8 || type == MEMSCAN_TYPE_UTF16;
+    bool validSize = type == MEMSCAN_TYPE_INT ? data_size == 1 || data_size == 2 || data_size == 4 || data_size == 8
+                   : type == MEMSCAN_TYPE_FLOAT ? data_size == 4 || data_size == 8 
+                   : isString;
+
+    if (!session || !validSize || !regions)
+    {
+        return MEMSCAN_ERROR_ARGUMENT;
+    }
+    *session = nullptr;
+
+    return guard([&]
+    {
+        RegionFilter filter;
+        std::string error;
+
+        if (!filter.parse(regions, error))
+        {
+            return MEMSCAN_ERROR_ARGUMENT;
+        }
+
+        // strings are searched at every byte like in the UI
+        std::shared_ptr<ScanSession> scan = ScanSession::open(process_id, isString ? 1 : data_size, 
+                                                              !isString && (flags & MEMSCAN_UNALIGNED), filter);
+        if (!scan)
+        {
+            return MEMSCAN_ERROR_PROCESS;
+        }
+
+        *session = new memscan_session(scan, threads, type, (flags & MEMSCAN_IGNORE_CASE) != 0);
+        return MEMSCAN_OK;
+    });
+}
+
+void memscan_close(memscan_session* session)
+{
+    delete session;
+}
+
+int memscan_scan_int(memscan_session* session, int condition, int64_t val, int64_t val2)
+{
+    if (!session || session->type != MEMSCAN_TYPE_INT || condition < MEMSCAN_COND_ALL || 
+        condition > MEMSCAN_COND_BITMASK)
+    {
+        return MEMSCAN_ERROR_ARGUMENT;
+    }
+
+    return guard([&]
+    {
+        IntScanner scanner(session->session, session->pool);
+
+        // relative conditions need values to compare with, like plans that start with a filter
+        if (!session->session->isScanned() && MemBlock::isRelative(static_cast<Condition>(condition)))
+        {
+            scanner.updateScan(COND_UNCONDITIONAL, 0);
+        }
+        scanner.updateScan(static_cast<Condition>(condition), val, val2);
+        return MEMSCAN_OK;
+    });
+}
+
+int memscan_scan_int_set(memscan_session* session, const int64_t* values, size_t count)
+{
+    if (!session || session->type != MEMSCAN_TYPE_INT || (!values && count > 0))
+    {
+        return MEMSCAN_ERROR_ARGUMENT;
+    }
+
+    return guard([&]
+    {
+        ValueSet set(std::vector<int64_t>(values, values + count), session->session->dataSize());
+        IntScanner(session->session, session->pool).updateScanSet(set);
+        return MEMSCAN_OK;
+    });
+}
+
+int memscan_scan_float(memscan_session* session, int condition, double low, double high)
+{
+    if (!session || session->type != MEMSCAN_TYPE_FLOAT || condition < MEMSCAN_COND_ALL || 
+        condition > MEMSCAN_COND_UNCHANGED)
+    {
+        return MEMSCAN_ERROR_ARGUMENT;
+    }
+
+    return guard([&]
+    {
+        FloatScanner scanner(session->session, session->pool);
+        FloatRange range = FloatRange::between(low, high);
+
+        if (!session->session->isScanned() && MemBlock::isRelative(static_cast<Condition>(condition)))
+        {
+            scanner.updateScan(COND_UNCONDITIONAL, range);
+        }
+        scanner.updateScan(static_cast<Condition>(condition), range);
+        return MEMSCAN_OK;
+    });
+}
+
+int memscan_scan_string(memscan_session* session, int condition, const char* value)
+{
+    if (!session || !value || (session->type != MEMSCAN_TYPE_UTF8 && session->type != MEMSCAN_TYPE_UTF16) ||
+        (condition != MEMSCAN_COND_EQUALS && condition != MEMSCAN_COND_INCREASED && 
+         condition != MEMSCAN_COND_DECREASED))
+    {
+        return MEMSCAN_ERROR_ARGUMENT;
+    }
+
+    return guard([&]
+    {
+        StringEncoding encoding = session->type == MEMSCAN_TYPE_UTF16 ? ENC_UTF16LE : ENC_UTF8;
+        StringScanner scanner(session->session, session->pool, encoding, session->ignoreCase);
+
+        if (!session->session->isScanned() && MemBlock::isRelative(static_cast<Condition>(condition)))
+        {
+            scanner.updateScan(COND_UNCONDITIONAL, value);
+        }
+        scanner.updateScan(static_cast<Condition>(condition), value);
+        session->valueSize = std::max<size_t>(scanner.encode(value).size(), 1);
+        return MEMSCAN_OK;
+    });
+}
+
+int memscan_refresh_regions(memscan_session* session, memscan_region_refresh* result)
+{
+    if (!session)
+    {
+        return MEMSCAN_ERROR_ARGUMENT;
+    }
+
+    return guard([&]
+    {
+        RegionRefresh refresh = session->session->refreshRegions(session->pool);
+
+        if (result)
+        {
+            *result = {refresh.keptBlocks, refresh.addedRegions, refresh.addedBytes, refresh.addedMatches,
+                       refresh.retiredBlocks, refresh.retiredBytes, refresh.retiredMatches};
+        }
+        return MEMSCAN_OK;
+    });
+}
+
+size_t memscan_match_count(const memscan_session* session)
+{
+    return session ? session->session->matches() : 0;
+}
+
+int memscan_for_each_match(const memscan_session* session, memscan_match_callback callback, void* user)
+{
+    if (!session || !callback)
+    {
+        return MEMSCAN_ERROR_ARGUMENT;
+    }
+
+    size_t valueSize = session->valueSize;
+    for (auto& mb : session->session->memblocks())
+    {
+        if (mb.matches() == 0)
+        {
+            continue;
+        }
+
+        if (mb.isSparse())
+        {
+            for (auto& match : mb.sparseMatches())
+            {
+                // little endian, the value starts with the bytes it was read as
+                int stop = callback(user, match.addr, &match.value, valueSize);
+                if (stop != 0)
+                {
+                    return stop;
+                }
+            }
+            continue;
+        }
+
+        const ByteBuffer& mask = mb.searchMask();
+        for (size_t byte = 0; byte < mask.size(); byte++)
+        {
+            if (mask[byte] == 0)
+            {
+                continue;
+            }
+
+            for (int bit = 0; bit < 8; bit++)
+            {
+                size_t offset = (byte * 8 + bit) * mb.stride();
+                if (!(mask[byte] & (1 << bit)) || offset + valueSize > mb.size())
+                {
+                    continue;
+                }
+
+                int stop = callback(user, reinterpret_cast<uintptr_t>(mb.addr()) + offset, mb.buffer().data() + offset,
+                                    valueSize);
+                if (stop != 0)
+                {
+                    return stop;
+                }
+            }
+        }
+    }
+
+    return MEMSCAN_OK;
+}
+
+size_t memscan_span_count(const memscan_session* session)
+{
+    return session ? session->session->memblocks().size() : 0;
+}
+
+int memscan_get_span(const memscan_session* session, size_t index, memscan_span* span)
+{
+    if (!session || !span || index >= session->session->memblocks().size())
+    {
+        return MEMSCAN_ERROR_ARGUMENT;
+    }
+
+    const MemBlock& mb = session->session->memblocks()[index];
+    span->addr = reinterpret_cast<uintptr_t>(mb.addr());
+    span->size = mb.size();
+    span->stride = mb.stride();
+    span->matches = mb.matches();
+    span->values = mb.isSparse() ? nullptr : mb.buffer().data();
+    span->mask = mb.isSparse() ? nullptr : reinterpret_cast<const uint8_t*>(mb.searchMask().data());
+    span->sparse = reinterpret_cast<const memscan_sparse_match*>(mb.sparseMatches().data());
+    span->sparse_count = mb.sparseMatches().size();
+    return MEMSCAN_OK;
+}
+
+int memscan_read(memscan_session* session, uintptr_t addr, void* buffer, size_t size, size_t* bytes_read)
+{
+    if (!session || (!buffer && size > 0))
+    {
+        return MEMSCAN_ERROR_ARGUMENT;
+    }
+
+    size_t bytesRead = Process::read(session->session->pHandle(), reinterpret_cast<const void*>(addr), buffer, size);
+    if (bytes_read)
+    {
+        *bytes_read = bytesRead;
+    }
+    return MEMSCAN_OK;
+}
+
+int memscan_write(memscan_session* session, uintptr_t addr, const void* buffer, size_t size)
+{
+    if (!session || (!buffer && size > 0))
+    {
+        return MEMSCAN_ERROR_ARGUMENT;
+    }
+
+    return Process::write(session->session->pHandle(), addr, buffer, size) ? MEMSCAN_OK : MEMSCAN_ERROR_PROCESS;
+}
\ No newline at end of file
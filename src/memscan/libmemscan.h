@@ -0,0 +1,169 @@
+#pragma once
+/**
+ * \brief C interface of the scanning engine, for programs that link memscan instead of driving its console.
+ *
+ * A session is one opened process with the values of one type. Scans narrow the matches of the session down like
+ * the passes of the UI, the first scan of a session reads all writable memory. If that first scan compares with
+ * previous values (increased, decreased, changed, unchanged, increased by, decreased by), the values are read once
+ * with MEMSCAN_COND_ALL right before it, so it compares with the memory as of the call. To catch a change over time,
+ * scan with MEMSCAN_COND_ALL first and filter after the change. Functions return MEMSCAN_OK or a negative
+ * memscan_status, nothing is printed and no exception leaves the library. A session may be used by one thread at a
+ * time, scans use the session's own thread pool.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(MEMSCAN_BUILD_DLL)
+    #define MEMSCAN_API __declspec(dllexport)
+#elif defined(__GNUC__)
+    #define MEMSCAN_API __attribute__((visibility("default")))
+#else
+    #define MEMSCAN_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEMSCAN_ABI_VERSION 1
+
+typedef struct memscan_session memscan_session;
+
+enum memscan_status
+{
+    MEMSCAN_OK = 0,
+    MEMSCAN_ERROR_ARGUMENT = -1,
+    MEMSCAN_ERROR_PROCESS = -2,
+    MEMSCAN_ERROR_MEMORY = -3,
+    MEMSCAN_ERROR_INTERNAL = -4
+};
+
+enum memscan_type
+{
+    MEMSCAN_TYPE_INT = 0,
+    MEMSCAN_TYPE_FLOAT = 1,
+    MEMSCAN_TYPE_UTF8 = 2,
+    MEMSCAN_TYPE_UTF16 = 3
+};
+
+/* flags of memscan_open */
+#define MEMSCAN_UNALIGNED 1u
+#define MEMSCAN_IGNORE_CASE 2u
+
+/* same values as the engine's Condition */
+enum memscan_condition
+{
+    MEMSCAN_COND_ALL = 0,
+    MEMSCAN_COND_EQUALS = 1,
+    MEMSCAN_COND_INCREASED = 2,
+    MEMSCAN_COND_DECREASED = 3,
+    MEMSCAN_COND_CHANGED = 4,
+    MEMSCAN_COND_UNCHANGED = 5,
+    MEMSCAN_COND_BETWEEN = 6,
+    MEMSCAN_COND_INCREASED_BY = 7,
+    MEMSCAN_COND_DECREASED_BY = 8,
+    MEMSCAN_COND_BITMASK = 9
+};
+
+/**
+ * \brief Match of a sparse span and its value as of the last scan, in the low bytes of value
+ */
+typedef struct memscan_sparse_match
+{
+    uintptr_t addr;
+    int64_t value;
+} memscan_sparse_match;
+
+/**
+ * \brief Matches of one memory region without copying them. A dense span has a copy of the region as of the last scan
+ * in values and one mask bit per stride bytes, bit i of byte i / 8 set if the value at addr + i * stride is a match.
+ * A sparse span lists its matches instead. Pointers stay valid until the next scan or memscan_close.
+ */
+typedef struct memscan_span
+{
+    uintptr_t addr;
+    size_t size;
+    size_t stride;
+    size_t matches;
+    const void* values;
+    const uint8_t* mask;
+    const memscan_sparse_match* sparse;
+    size_t sparse_count;
+} memscan_span;
+
+/**
+ * \brief Outcome of memscan_refresh_regions. Retired blocks took their remaining matches with them, added regions
+ * start with every readable value as a match.
+ */
+typedef struct memscan_region_refresh
+{
+    size_t kept_blocks;
+    size_t added_regions;
+    size_t added_bytes;
+    size_t added_matches;
+    size_t retired_blocks;
+    size_t retired_bytes;
+    size_t retired_matches;
+} memscan_region_refresh;
+
+/**
+ * \brief Called for every match with its value as of the last scan. Return 0 to go on, anything else stops the 
+ * iteration and is returned by memscan_for_each_match.
+ */
+typedef int (*memscan_match_callback)(void* user, uintptr_t addr, const void* value, size_t size);
+
+MEMSCAN_API int memscan_abi_version(void);
+MEMSCAN_API const char* memscan_status_string(int status);
+
+/**
+ * \param type memscan_type
+ * \param data_size 1, 2, 4 or 8 for integers, 4 or 8 for floats, ignored for strings
+ * \param flags MEMSCAN_UNALIGNED for numbers at any address, MEMSCAN_IGNORE_CASE for strings
+ * \param threads Threads used by scans, 0 for all hardware threads
+ */
+MEMSCAN_API int memscan_open(int process_id, int type, int data_size, unsigned flags, int threads,
+                             memscan_session** session);
+/**
+ * \brief memscan_open limited to some regions of the process
+ * \param regions Region filter in the syntax of the --regions option, e.g. "heap anon min:64k"
+ */
+MEMSCAN_API int memscan_open_filtered(int process_id, int type, int data_size, unsigned flags, int threads,
+                                      const char* regions, memscan_session** session);
+MEMSCAN_API void memscan_close(memscan_session* session);
+
+/**
+ * \param val Value of EQUALS and BITMASK, lower bound of BETWEEN, difference of INCREASED_BY and DECREASED_BY
+ * \param val2 Upper bound of BETWEEN (included), mask of BITMASK
+ */
+MEMSCAN_API int memscan_scan_int(memscan_session* session, int condition, int64_t val, int64_t val2);
+MEMSCAN_API int memscan_scan_int_set(memscan_session* session, const int64_t* values, size_t count);
+/**
+ * \brief low and high are both included, equal for an exact value. Only EQUALS uses them.
+ */
+MEMSCAN_API int memscan_scan_float(memscan_session* session, int condition, double low, double high);
+/**
+ * \param value UTF-8 string, converted to the encoding of the session
+ */
+MEMSCAN_API int memscan_scan_string(memscan_session* session, int condition, const char* value);
+/**
+ * \brief Add the regions mapped since the session was opened or last refreshed and retire the blocks whose memory is
+ * gone. The region filter of the session applies to the new regions.
+ * \param result Set to the counts of the refresh, may be NULL
+ */
+MEMSCAN_API int memscan_refresh_regions(memscan_session* session, memscan_region_refresh* result);
+
+MEMSCAN_API size_t memscan_match_count(const memscan_session* session);
+MEMSCAN_API int memscan_for_each_match(const memscan_session* session, memscan_match_callback callback, void* user);
+MEMSCAN_API size_t memscan_span_count(const memscan_session* session);
+MEMSCAN_API int memscan_get_span(const memscan_session* session, size_t index, memscan_span* span);
+
+/**
+ * \param bytes_read Set to the bytes read, may be NULL. Reading less than size isn't an error.
+ */
+MEMSCAN_API int memscan_read(memscan_session* session, uintptr_t addr, void* buffer, size_t size, 
+                             size_t* bytes_read);
+MEMSCAN_API int memscan_write(memscan_session* session, uintptr_t addr, const void* buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
\ No newline at end of file
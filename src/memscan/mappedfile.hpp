@@ -0,0 +1,40 @@
+#pragma once
+#ifdef _WIN32
+#include <handleapi.h>
+#endif
+
+#include <cstddef>
+#include <string>
+
+/**
+ * \brief Whole file mapped into memory, copy on write.
+ *
+ * Pages are only read from disk when they are first touched and changes stay private to the process, so a mapped
+ * file can back buffers that are written to without ever touching the file itself.
+ * \param path File to map
+ */
+class MappedFile
+{
+    public:
+        MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool isValid() const { return m_data != nullptr; }
+
+              char*         data()       { return m_data; }
+        const char*         data() const { return m_data; }
+        const size_t&       size() const { return m_size; }
+        const std::string&  path() const { return m_path; }
+
+    private:
+        std::string m_path;
+        char* m_data;
+        size_t m_size;
+#ifdef _WIN32
+        HANDLE m_file;
+        HANDLE m_mapping;
+#endif
+};
\ No newline at end of file
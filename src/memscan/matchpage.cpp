@@ -0,0 +1,168 @@
+#include "blockreader.hpp"
+#include "matchpage.hpp"
+
+#include <algorithm>
+
+MatchPage::MatchPage(ProcessHandle pHandle, const std::vector<MemBlock>& memblocks, size_t first, size_t limit,
+                     size_t valueSize, bool hasSnapshot)
+    : m_first(first)
+    , m_total(0)
+    , m_next{0, 0}
+{
+    for (auto& mb : memblocks)
+    {
+        m_total += mb.matches();
+    }
+
+    collect(memblocks, first, limit, valueSize, hasSnapshot);
+    refresh(pHandle, valueSize);
+}
+
+MatchPage::MatchPage(ProcessHandle pHandle, const std::vector<MemBlock>& memblocks, const MatchCursor& from,
+                     size_t limit, size_t valueSize, bool hasSnapshot)
+    : m_first(0)
+    , m_total(0)
+    , m_next(from)
+{
+    for (auto& mb : memblocks)
+    {
+        m_total += mb.matches();
+    }
+
+    collect(memblocks, 0, limit, valueSize, hasSnapshot);
+    refresh(pHandle, valueSize);
+}
+
+/**
+ * \brief Find the addresses of the page, starting skip matches after m_next, and move m_next behind them. Whole
+ * blocks are skipped by their match count, empty mask bytes 8 values at a time.
+ */
+void MatchPage::collect(const std::vector<MemBlock>& memblocks, size_t skip, size_t limit, size_t valueSize, 
+                        bool hasSnapshot)
+{
+    size_t count = limit == 0 ? m_total : limit;
+
+    for (; m_next.block < memblocks.size(); m_next.block++, m_next.element = 0)
+    {
+        const MemBlock& mb = memblocks[m_next.block];
+
+        if (m_next.element == 0 && skip >= mb.matches())
+        {
+            skip -= mb.matches();
+            continue;
+        }
+
+        if (mb.isSparse())
+        {
+            size_t& i = m_next.element;
+
+            for (i += skip; i < mb.sparseMatches().size() && m_entries.size() < count; i++)
+            {
+                const SparseMatch& match = mb.sparseMatches()[i];
+                // little endian, the value of a sparse match starts with the bytes it was read as
+                const char* snapshot = hasSnapshot ? reinterpret_cast<const char*>(&match.value) : nullptr;
+
+                m_entries.push_back({match.addr, &mb, snapshot, nullptr});
+            }
+            skip = 0;
+        }
+        else
+        {
+            collectDense(mb, skip, count, valueSize, hasSnapshot);
+        }
+
+        // a full page keeps the cursor in the block
+        if (m_entries.size() >= count)
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * \brief Add the matches of a dense block from the mask bit at m_next.element on
+ */
+void MatchPage::collectDense(const MemBlock& mb, size_t& skip, size_t count, size_t valueSize, bool hasSnapshot)
+{
+    const ByteBuffer& mask = mb.searchMask();
+    size_t& index = m_next.element;
+
+    for (; index < mask.size() * 8 && m_entries.size() < count; index++)
+    {
+        char byte = mask[index / 8];
+        size_t offset = index * mb.stride();
+
+        if (byte == 0)
+        {
+            // to the last bit of the byte, the loop moves on to the next one
+            index |= 7;
+            continue;
+        }
+        if (!(byte & (1 << (index % 8))) || offset + valueSize > mb.size())
+        {
+            continue;
+        }
+        if (skip > 0)
+        {
+            skip--;
+            continue;
+        }
+
+        const char* snapshot = hasSnapshot ? mb.buffer().data() + offset : nullptr;
+        m_entries.push_back({reinterpret_cast<uintptr_t>(mb.addr()) + offset, &mb, snapshot, nullptr});
+    }
+}
+
+/**
+ * \brief Read the current values of the page with one batch. Nearby matches of the same block share a request.
+ */
+void MatchPage::refresh(ProcessHandle pHandle, size_t valueSize)
+{
+    std::vector<ReadRequest> requests;
+    std::vector<size_t> firstEntry;
+    size_t bufferSize = 0;
+
+    for (size_t i = 0; i < m_entries.size(); i++)
+    {
+        const PageEntry& entry = m_entries[i];
+        uintptr_t spanEnd = requests.empty() ? 0 : reinterpret_cast<uintptr_t>(requests.back().addr) +
+                                                   requests.back().size;
+
+        // entries are sorted, unaligned values may overlap the previous one
+        if (requests.empty() || entry.block != m_entries[i-1].block || 
+            (entry.addr > spanEnd && entry.addr - spanEnd > BlockReader::sparseGap))
+        {
+            requests.push_back({reinterpret_cast<char*>(entry.addr), nullptr, 0, 0});
+            firstEntry.push_back(i);
+        }
+
+        size_t size = std::max(requests.back().size, 
+                               entry.addr + valueSize - reinterpret_cast<uintptr_t>(requests.back().addr));
+        bufferSize += size - requests.back().size;
+        requests.back().size = size;
+    }
+
+    // the buffer is complete, so it doesn't move anymore
+    m_buffer.resize(bufferSize);
+    firstEntry.push_back(m_entries.size());
+    for (size_t i = 0, offset = 0; i < requests.size(); i++)
+    {
+        requests[i].buffer = m_buffer.data() + offset;
+        offset += requests[i].size;
+    }
+
+    Process::readBatch(pHandle, requests);
+
+    for (size_t i = 0; i < requests.size(); i++)
+    {
+        for (size_t entry = firstEntry[i]; entry < firstEntry[i+1]; entry++)
+        {
+            size_t offset = m_entries[entry].addr - reinterpret_cast<uintptr_t>(requests[i].addr);
+
+            if (offset + valueSize <= requests[i].bytesRead)
+            {
+                m_entries[entry].current = requests[i].buffer + offset;
+            }
+        }
+    }
+}
\ No newline at end of file
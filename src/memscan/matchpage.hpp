@@ -0,0 +1,70 @@
+#pragma once
+#include "memblock.hpp"
+#include "process.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * \brief Single match of a MatchPage. snapshot points to the value as of the last scan, or is nullptr if the scanner
+ * doesn't store values. current points to the value just read, or is nullptr if it couldn't be read.
+ */
+struct PageEntry
+{
+    uintptr_t addr;
+    const MemBlock* block;
+    const char* snapshot;
+    const char* current;
+};
+
+/**
+ * \brief Position in the matches of a scan: a block and the sparse match or mask bit in it
+ */
+struct MatchCursor
+{
+    size_t block;
+    size_t element;
+};
+
+/**
+ * \brief Matches [first, first + limit) of a scan with their current values.
+ *
+ * Skipping to first uses the match counts of the blocks and the search mask a byte at a time, so late pages are as
+ * cheap as early ones. The current values of the page are refreshed with a single Process::readBatch, matches closer
+ * than BlockReader::sparseGap share one request.
+ * \param pHandle Process handle
+ * \param memblocks Blocks of the scan
+ * \param first Index of the first match on the page
+ * \param limit Number of matches on the page, 0 for all of them
+ * \param valueSize Bytes read per match
+ * \param hasSnapshot MemBlock buffers hold the values of the last scan
+ *
+ * Pages that follow each other can also start at the next() cursor of the previous page, which costs nothing for the
+ * matches before it. first() is 0 for those.
+ */
+class MatchPage
+{
+    public:
+        MatchPage(ProcessHandle pHandle, const std::vector<MemBlock>& memblocks, size_t first, size_t limit,
+                  size_t valueSize, bool hasSnapshot);
+        MatchPage(ProcessHandle pHandle, const std::vector<MemBlock>& memblocks, const MatchCursor& from, 
+                  size_t limit, size_t valueSize, bool hasSnapshot);
+
+        const std::vector<PageEntry>& entries() const { return m_entries; }
+        const size_t&                 first()   const { return m_first; }
+        const size_t&                 total()   const { return m_total; }
+        const MatchCursor&            next()    const { return m_next; }
+
+    private:
+        std::vector<PageEntry> m_entries;
+        std::vector<char> m_buffer;
+        size_t m_first;
+        size_t m_total;
+        MatchCursor m_next;
+
+        void collect(const std::vector<MemBlock>& memblocks, size_t skip, size_t limit, size_t valueSize, 
+                     bool hasSnapshot);
+        void collectDense(const MemBlock& mb, size_t& skip, size_t count, size_t valueSize, bool hasSnapshot);
+        void refresh(ProcessHandle pHandle, size_t valueSize);
+};
\ No newline at end of file
@@ -1,37 +1,51 @@
 #include "memblock.hpp"
 
 #include <algorithm>
+#include <cstring>
 
-MemBlock::MemBlock(HANDLE pHandle, MEMORY_BASIC_INFORMATION* memInfo, int dataSize)
+MemBlock::MemBlock(ProcessHandle pHandle, const Region& region, int dataSize, bool unaligned, bool hasSnapshot)
     : m_pHandle(pHandle)
-    , m_addr(static_cast<char*>(memInfo->BaseAddress))
-    , m_searchMask(memInfo->RegionSize/8, 0xff)
-    , m_size(memInfo->RegionSize)
-    , m_matches(memInfo->RegionSize)
+    , m_addr(region.addr)
+    , m_size(region.size)
     , m_dataSize(dataSize)
+    , m_stride(unaligned ? 1 : dataSize)
+    , m_isSparse(false)
 {
-    m_buffer.resize(memInfo->RegionSize);
+    m_matches = elementCount(region.size);
+    m_searchMask.resize((m_matches+7)/8, 0xff);
+    if (hasSnapshot)
+    {
+        m_buffer.resize(region.size);
+    }
 }
 
 /**
- * \brief Check if BASIC_MEMORY_INFORMATION protect condition allows for reading and writing to memory location
- * \param protectCond Value of BASIC_MEMORY_INFORMATION.protect (DWORD i.e. int32)
- * \return Boolean
+ * \brief Restore a block as saved by SessionFile. The block is sparse if it has no search mask, and has no snapshot if
+ * buffer is empty.
  */
-bool MemBlock::checkPage(int32_t protectCond)
-{
-    auto condIter = std::find(writable.begin(), writable.end(), protectCond);
-    return condIter != writable.end() ? true : false;
-}
+MemBlock::MemBlock(ProcessHandle pHandle, const Region& region, int dataSize, int stride, size_t matches, 
+                   ByteBuffer&& buffer, ByteBuffer&& searchMask, std::vector<SparseMatch>&& sparseMatches)
+    : m_pHandle(pHandle)
+    , m_addr(region.addr)
+    , m_buffer(std::move(buffer))
+    , m_searchMask(std::move(searchMask))
+    , m_sparseMatches(std::move(sparseMatches))
+    , m_size(region.size)
+    , m_matches(matches)
+    , m_dataSize(dataSize)
+    , m_stride(stride)
+    , m_isSparse(m_searchMask.empty())
+{}
 
 /**
- * \brief Check if offset byte is in mask
+ * \brief Check if value at offset byte is in mask. The mask has one bit per stride bytes.
  * 
  * \return Boolean
  */
-bool MemBlock::isInSearch(int offset)
+bool MemBlock::isInSearch(size_t offset)
 {
-    return (m_searchMask[(offset)/8] & (1<<(offset)%8));
+    size_t index = offset / m_stride;
+    return (m_searchMask[index/8] & (1<<index%8));
 }
 
 /**
@@ -40,7 +54,138 @@ bool MemBlock::isInSearch(int offset)
  * \param mb Memory block
  * \param offset Offset byte
  */
-void MemBlock::removeFromSearch(int offset)
+void MemBlock::removeFromSearch(size_t offset)
+{
+    size_t index = offset / m_stride;
+    m_searchMask[index/8] &= ~(1<<index%8);
+}
+
+/**
+ * \brief Update mask to include or exclude elements [firstIndex, lastIndex)
+ * 
+ * \param firstIndex Index of first element
+ * \param lastIndex Index after last element
+ * \param inSearch True to include, false to exclude
+ */
+void MemBlock::fillSearch(size_t firstIndex, size_t lastIndex, bool inSearch)
+{
+    size_t index = firstIndex;
+
+    for (; index < lastIndex && index % 8 != 0; index++)
+    {
+        inSearch ? m_searchMask[index/8] |= (1<<index%8) : m_searchMask[index/8] &= ~(1<<index%8);
+    }
+    if (index < lastIndex)
+    {
+        std::fill(m_searchMask.begin() + index/8, m_searchMask.begin() + lastIndex/8, inSearch ? 0xff : 0);
+    }
+    for (index = std::max(index, lastIndex/8*8); index < lastIndex; index++)
+    {
+        inSearch ? m_searchMask[index/8] |= (1<<index%8) : m_searchMask[index/8] &= ~(1<<index%8);
+    }
+}
+
+/**
+ * \brief Number of whole values that start every stride bytes in given amount of bytes
+ */
+size_t MemBlock::elementCount(size_t bytes) const
+{
+    return bytes < static_cast<size_t>(m_dataSize) ? 0 : (bytes - m_dataSize) / m_stride + 1;
+}
+
+/**
+ * \brief Check if dense block has so few matches left that a sparse list is smaller and faster to scan
+ * 
+ * \return Boolean
+ */
+bool MemBlock::shouldBeSparse() const
+{
+    return !m_isSparse && m_matches * sparseRatio <= m_size;
+}
+
+/**
+ * \brief Move matches from search mask to a sorted list of (address, previous value) and free the dense buffers
+ */
+void MemBlock::makeSparse()
+{
+    std::vector<SparseMatch> sparseMatches;
+
+    size_t elements = elementCount(m_size);
+
+    sparseMatches.reserve(m_matches);
+    for (size_t maskIndex = 0; maskIndex < m_searchMask.size(); maskIndex++)
+    {
+        if (m_searchMask[maskIndex] == 0)
+        {
+            continue;
+        }
+        for (size_t index = maskIndex*8; index < maskIndex*8 + 8 && index < elements; index++)
+        {
+            if (m_searchMask[index/8] & (1<<index%8))
+            {
+                size_t offset = index * m_stride;
+                sparseMatches.push_back({reinterpret_cast<uintptr_t>(m_addr) + offset, 
+                                         toInt(&m_buffer[offset], m_dataSize)});
+            }
+        }
+    }
+
+    m_sparseMatches.swap(sparseMatches);
+    m_buffer.clear();
+    m_searchMask.clear();
+    m_matches = m_sparseMatches.size();
+    m_isSparse = true;
+}
+
+/**
+ * \brief Sign extend integer of dataSize bytes
+ * 
+ * \param data Pointer to integer
+ * \param dataSize Integer size in bytes
+ * \return Integer as int64_t
+ */
+int64_t MemBlock::toInt(const char* data, int dataSize)
+{
+    int8_t valInt8;
+    int16_t valInt16;
+    int32_t valInt32;
+    int64_t valInt64;
+
+    switch (dataSize)
+    {
+        case 1:
+            std::memcpy(&valInt8, data, 1);
+            return valInt8;
+        case 2:
+            std::memcpy(&valInt16, data, 2);
+            return valInt16;
+        case 4:
+        default:
+            std::memcpy(&valInt32, data, 4);
+            return valInt32;
+        case 8:
+            std::memcpy(&valInt64, data, 8);
+            return valInt64;
+    }
+}
+
+/**
+ * \brief Check if condition compares with the values of the previous scan
+ */
+bool MemBlock::isRelative(Condition condition)
+{
+    return condition == COND_INCREASED || condition == COND_DECREASED || condition == COND_CHANGED || 
+           condition == COND_UNCHANGED || condition == COND_INCREASED_BY || condition == COND_DECREASED_BY;
+}
+
+/**
+ * \brief Drop blocks without matches. Their buffers and masks are freed with them.
+ * 
+ * \param memblocks Vector of MemBlocks
+ */
+void MemBlock::removeDead(std::vector<MemBlock>& memblocks)
 {
-    m_searchMask[(offset)/8] &= ~(1<<(offset)%8);
+    memblocks.erase(std::remove_if(memblocks.begin(), memblocks.end(), 
+                                   [](const MemBlock& mb) { return mb.matches() == 0; }), 
+                    memblocks.end());
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
-#include <handleapi.h>
+#include "bytebuffer.hpp"
+#include "process.hpp"
 
 #include <cstdint>
 #include <vector>
@@ -10,48 +11,92 @@ enum Condition
     COND_UNCONDITIONAL, 
     COND_EQUALS,
     COND_INCREASED,
-    COND_DECREASED
+    COND_DECREASED,
+    COND_CHANGED,
+    COND_UNCHANGED,
+    COND_BETWEEN,
+    COND_INCREASED_BY,
+    COND_DECREASED_BY,
+    COND_BITMASK
+};
+
+/**
+ * \brief Surviving address of a sparse MemBlock and its previous value
+ */
+struct SparseMatch
+{
+    uintptr_t addr;
+    int64_t value;
 };
 
 /** 
- * \brief Single memory block
+ * \brief Single memory block.
+ *
+ * Blocks start dense: a copy of the whole region plus a search mask. Once few enough matches survive, integer scans
+ * switch the block to a sorted list of SparseMatches and free the dense buffers.
  * \param pHandle Process handle
- * \param memInfo Process memory info
+ * \param region Writable memory region of the process
  * \param dataSize Data size for stored data in bytes. String values don't care about this parameter.
+ * \param unaligned Search values at every byte instead of every dataSize bytes
+ * \param hasSnapshot Keep a copy of the region for scans that compare with previous values. Without it the block
+ * only has a search mask.
  */
 class MemBlock
 {
     public:
-        MemBlock(HANDLE pHandle, MEMORY_BASIC_INFORMATION* memInfo, int dataSize);
+        MemBlock(ProcessHandle pHandle, const Region& region, int dataSize, bool unaligned, bool hasSnapshot = true);
+        MemBlock(ProcessHandle pHandle, const Region& region, int dataSize, int stride, size_t matches, 
+                 ByteBuffer&& buffer, ByteBuffer&& searchMask, std::vector<SparseMatch>&& sparseMatches);
 
-        bool static checkPage(int32_t protectCond);
-        bool isInSearch(int offset);
-        void removeFromSearch(int offset);
+        // blocks hold a copy of their whole region, they are only ever moved
+        MemBlock(const MemBlock&) = delete;
+        MemBlock& operator=(const MemBlock&) = delete;
+        MemBlock(MemBlock&&) = default;
+        MemBlock& operator=(MemBlock&&) = default;
 
-              HANDLE&            pHandle()          { return m_pHandle; }
-        const HANDLE&            pHandle()    const { return m_pHandle; }
+        bool isInSearch(size_t offset);
+        void removeFromSearch(size_t offset);
+        void fillSearch(size_t firstIndex, size_t lastIndex, bool inSearch);
+        size_t elementCount(size_t bytes) const;
+        bool shouldBeSparse() const;
+        void makeSparse();
+
+        static int64_t toInt(const char* data, int dataSize);
+        static bool isRelative(Condition condition);
+        static void removeDead(std::vector<MemBlock>& memblocks);
+
+              ProcessHandle&     pHandle()          { return m_pHandle; }
+        const ProcessHandle&     pHandle()    const { return m_pHandle; }
               char*              addr()             { return m_addr; }
         const char*              addr()       const { return m_addr; }
-              int&               size()             { return m_size; }
-        const int&               size()       const { return m_size; }
-              std::vector<char>& buffer()           { return m_buffer; }
-        const std::vector<char>& buffer()     const { return m_buffer; }
-              std::vector<char>& searchMask()       { return m_searchMask; }
-        const std::vector<char>& searchMask() const { return m_searchMask; }
-              int&               matches()          { return m_matches; }
-        const int&               matches()    const { return m_matches; }
+              size_t&            size()             { return m_size; }
+        const size_t&            size()       const { return m_size; }
+              ByteBuffer&        buffer()           { return m_buffer; }
+        const ByteBuffer&        buffer()     const { return m_buffer; }
+              ByteBuffer&        searchMask()       { return m_searchMask; }
+        const ByteBuffer&        searchMask() const { return m_searchMask; }
+              size_t&            matches()          { return m_matches; }
+        const size_t&            matches()    const { return m_matches; }
               int&               dataSize()         { return m_dataSize; }
         const int&               dataSize()   const { return m_dataSize; }
+        const int&               stride()     const { return m_stride; }
+        const bool&              isSparse()   const { return m_isSparse; }
+
+              std::vector<SparseMatch>& sparseMatches()       { return m_sparseMatches; }
+        const std::vector<SparseMatch>& sparseMatches() const { return m_sparseMatches; }
 
-        const static inline std::vector<int> writable {PAGE_READWRITE, PAGE_WRITECOPY, PAGE_EXECUTE_READWRITE,        
-                                                       PAGE_EXECUTE_WRITECOPY};
+        // a block turns sparse when it has at most one match per sparseRatio bytes
+        const static inline size_t sparseRatio = 1024;
 
     private:
-        HANDLE m_pHandle;
+        ProcessHandle m_pHandle;
         char* m_addr;
-        std::vector<char> m_buffer;
-        std::vector<char> m_searchMask;
-        int m_size;
-        int m_matches;
+        ByteBuffer m_buffer;
+        ByteBuffer m_searchMask;
+        std::vector<SparseMatch> m_sparseMatches;
+        size_t m_size;
+        size_t m_matches;
         int m_dataSize;
+        int m_stride;
+        bool m_isSparse;
 };
\ No newline at end of file
@@ -1,20 +1,138 @@
 #include "scanner.hpp"
+#include "aobscanner.hpp"
+#include "cli.hpp"
+#include "floatscanner.hpp"
 #include "intscanner.hpp"
 #include "stringscanner.hpp"
 
-int main() 
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) 
 {
-    Scanner scanner;
+    int threadCount = 0;
+    // 1 kHz
+    std::chrono::microseconds freezeInterval(1000);
+    size_t maxMatches = 100;
     int returnCode = 1;
+    int dumpPid = 0;
+    std::string dumpPath;
+    std::string diffBefore;
+    std::string diffAfter;
+    std::string diffCondition;
+    int dataSize = 4;
+    int planPid = 0;
+    std::string planType = "i32";
+    std::string planPath;
+    std::string planFormat = "ndjson";
+    std::string outputPath;
+    std::string serverPath;
+    RegionFilter regionFilter;
+    std::string filterError;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i+1 < argc)
+        {
+            threadCount = std::atoi(argv[++i]);
+        }
+        else if (arg == "--freeze-interval" && i+1 < argc)
+        {
+            freezeInterval = std::chrono::microseconds(std::atoll(argv[++i]));
+        }
+        else if (arg == "--max-matches" && i+1 < argc)
+        {
+            maxMatches = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--dump" && i+2 < argc)
+        {
+            dumpPid = std::atoi(argv[++i]);
+            dumpPath = argv[++i];
+        }
+        else if (arg == "--diff" && i+3 < argc)
+        {
+            diffBefore = argv[++i];
+            diffAfter = argv[++i];
+            diffCondition = argv[++i];
+        }
+        else if (arg == "--size" && i+1 < argc)
+        {
+            dataSize = std::atoi(argv[++i]);
+        }
+        else if (arg == "--pid" && i+1 < argc)
+        {
+            planPid = std::atoi(argv[++i]);
+        }
+        else if (arg == "--type" && i+1 < argc)
+        {
+            planType = argv[++i];
+        }
+        else if (arg == "--plan" && i+1 < argc)
+        {
+            planPath = argv[++i];
+        }
+        else if (arg == "--format" && i+1 < argc)
+        {
+            planFormat = argv[++i];
+        }
+        else if (arg == "--output" && i+1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else if (arg == "--server" && i+1 < argc)
+        {
+            serverPath = argv[++i];
+        }
+        else if (arg == "--regions" && i+1 < argc)
+        {
+            if (!regionFilter.parse(argv[++i], filterError))
+            {
+                std::cerr << "Invalid region filter " << filterError << "\n";
+                return 1;
+            }
+        }
+    }
+
+    if (!dumpPath.empty())
+    {
+        return Cli::dump(dumpPid, dumpPath, regionFilter);
+    }
+    if (!diffBefore.empty())
+    {
+        return Cli::diff(diffBefore, diffAfter, diffCondition, dataSize, threadCount);
+    }
+    if (!serverPath.empty())
+    {
+        return Cli::serve(serverPath, threadCount, freezeInterval, regionFilter);
+    }
+    if (!planPath.empty())
+    {
+        return Cli::plan(planPid, planType, planPath, planFormat, outputPath, threadCount, regionFilter);
+    }
+
+    Scanner scanner(threadCount, freezeInterval, maxMatches, regionFilter);
 
     while (returnCode)
     {
         scanner.uiNewScan();
-        if (scanner.isString())
+        if (scanner.scanType() == SCAN_STRING)
         {
             StringScanner strScan = scanner.createStringScanner(scanner.startCondition());
             returnCode = scanner.openStringUi(strScan);
         }
+        else if (scanner.scanType() == SCAN_AOB)
+        {
+            AobScanner aobScan = scanner.createAobScanner();
+            returnCode = scanner.openAobUi(aobScan);
+        }
+        else if (scanner.scanType() == SCAN_FLOAT)
+        {
+            FloatScanner floatScan = scanner.createFloatScanner(scanner.startCondition());
+            returnCode = scanner.openFloatUi(floatScan);
+        }
         else
         {
             IntScanner intScan = scanner.createIntScanner(scanner.startCondition());
@@ -0,0 +1,328 @@
+#include "blockreader.hpp"
+#include "pointerscanner.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * \brief Build the map with one pass over all writable regions.
+ *
+ * Regions are read in batches of up to BlockReader::batchBytes into a reused buffer, each read of chunkBytes is
+ * filtered by one worker. Only the small per-worker lists of pointers are kept, never a copy of the memory.
+ */
+PointerMap::PointerMap(ProcessHandle pHandle, ThreadPool& pool)
+{
+    std::vector<Region> regions = Process::writableRegions(pHandle);
+    std::vector<std::vector<Entry>> found(pool.threadCount());
+    std::vector<ReadRequest> requests;
+    std::vector<char> buffer(BlockReader::batchBytes);
+    size_t region = 0;
+    size_t offset = 0;
+
+    std::sort(regions.begin(), regions.end(), [](const Region& a, const Region& b) { return a.addr < b.addr; });
+    if (regions.empty())
+    {
+        return;
+    }
+
+    uintptr_t lowest = reinterpret_cast<uintptr_t>(regions.front().addr);
+    uintptr_t highest = reinterpret_cast<uintptr_t>(regions.back().addr) + regions.back().size;
+
+    auto filterRead = [&](size_t task, int worker)
+    {
+        const ReadRequest& read = requests[task];
+        uintptr_t addr = reinterpret_cast<uintptr_t>(read.addr);
+        size_t last = 0;
+
+        for (size_t i = 0; i + sizeof(uintptr_t) <= read.bytesRead; i += sizeof(uintptr_t))
+        {
+            uintptr_t value;
+            std::memcpy(&value, static_cast<char*>(read.buffer) + i, sizeof(value));
+
+            if (value < lowest || value >= highest)
+            {
+                continue;
+            }
+            // pointers cluster, so the region of the previous hit is the first guess
+            uintptr_t start = reinterpret_cast<uintptr_t>(regions[last].addr);
+            if (value < start || value >= start + regions[last].size)
+            {
+                auto next = std::upper_bound(regions.begin(), regions.end(), value,
+                    [](uintptr_t val, const Region& r) { return val < reinterpret_cast<uintptr_t>(r.addr); });
+                if (next == regions.begin())
+                {
+                    continue;
+                }
+                last = next - regions.begin() - 1;
+                start = reinterpret_cast<uintptr_t>(regions[last].addr);
+                if (value >= start + regions[last].size)
+                {
+                    continue;
+                }
+            }
+            found[worker].push_back({value, addr + i});
+        }
+    };
+
+    while (region < regions.size())
+    {
+        size_t batchSize = 0;
+
+        requests.clear();
+        while (region < regions.size() && batchSize + BlockReader::chunkBytes <= BlockReader::batchBytes)
+        {
+            size_t size = std::min(BlockReader::chunkBytes, regions[region].size - offset);
+
+            requests.push_back({regions[region].addr + offset, buffer.data() + batchSize, size, 0});
+            batchSize += size;
+            offset += size;
+            if (offset == regions[region].size)
+            {
+                region++;
+                offset = 0;
+            }
+        }
+
+        Process::readBatch(pHandle, requests);
+        pool.run(requests.size(), filterRead);
+    }
+
+    merge(found, pool);
+}
+
+/**
+ * \brief Sort the per-worker lists in parallel, merge them pairwise and split the result into values and locations
+ */
+void PointerMap::merge(std::vector<std::vector<Entry>>& found, ThreadPool& pool)
+{
+    std::vector<Entry> entries;
+    std::vector<size_t> bounds {0};
+
+    pool.run(found.size(), [&](size_t task, int) { std::sort(found[task].begin(), found[task].end()); });
+    for (auto& list : found)
+    {
+        entries.insert(entries.end(), list.begin(), list.end());
+        bounds.push_back(entries.size());
+        std::vector<Entry>().swap(list);
+    }
+
+    // every round merges neighbouring runs, halving their number
+    while (bounds.size() > 2)
+    {
+        std::vector<size_t> merged;
+
+        pool.run((bounds.size() - 1) / 2, [&](size_t task, int)
+        {
+            std::inplace_merge(entries.begin() + bounds[2*task], entries.begin() + bounds[2*task+1],
+                               entries.begin() + bounds[2*task+2]);
+        });
+        for (size_t i = 0; i < bounds.size(); i += 2)
+        {
+            merged.push_back(bounds[i]);
+        }
+        if (merged.back() != bounds.back())
+        {
+            merged.push_back(bounds.back());
+        }
+        bounds.swap(merged);
+    }
+
+    m_values.resize(entries.size());
+    m_locations.resize(entries.size());
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        m_values[i] = entries[i].value;
+        m_locations[i] = entries[i].location;
+    }
+    for (size_t i = 0; i < m_values.size(); i += indexStride)
+    {
+        m_index.push_back(m_values[i]);
+    }
+}
+
+/**
+ * \brief Index of the first value that is not below val
+ */
+size_t PointerMap::lowerBound(uintptr_t val) const
+{
+    // the first sample not below val ends the run that holds the answer
+    size_t run = std::lower_bound(m_index.begin(), m_index.end(), val) - m_index.begin();
+    size_t first = run == 0 ? 0 : (run - 1) * indexStride;
+    size_t last = std::min(run * indexStride, m_values.size());
+
+    return std::lower_bound(m_values.begin() + first, m_values.begin() + last, val) - m_values.begin();
+}
+
+/**
+ * \brief Entries [first, last) whose value is in [low, high]
+ */
+std::pair<size_t, size_t> PointerMap::find(uintptr_t low, uintptr_t high) const
+{
+    size_t first = lowerBound(low);
+    size_t last = high == UINTPTR_MAX ? m_values.size() : lowerBound(high + 1);
+
+    return {first, last};
+}
+
+PointerScanner::PointerScanner(std::shared_ptr<ScanSession> session, ThreadPool& pool)
+    : m_session(session)
+    , m_pool(pool)
+    , m_modules(Process::modules(session->pHandle()))
+    , m_map(session->pHandle(), pool)
+{}
+
+/**
+ * \brief Module that addr lies in, or nullptr if addr isn't static
+ */
+const Module* PointerScanner::findModule(uintptr_t addr) const
+{
+    auto next = std::upper_bound(m_modules.begin(), m_modules.end(), addr,
+        [](uintptr_t val, const Module& module) { return val < module.base; });
+
+    if (next == m_modules.begin() || addr >= (next-1)->base + (next-1)->size)
+    {
+        return nullptr;
+    }
+
+    return &*(next-1);
+}
+
+/**
+ * \brief Append the path of a static location to the worker's buffer. Offsets were collected walking back from the
+ * target, so they are written in reverse to get dereference order.
+ * \return False once maxResults paths were found
+ */
+bool PointerScanner::emitPath(const Module& module, uintptr_t location, const std::vector<size_t>& offsets,
+                              SearchState& state, std::string& buffer)
+{
+    char text[32];
+
+    if (state.found++ >= state.maxResults)
+    {
+        return false;
+    }
+
+    std::snprintf(text, sizeof(text), "+0x%llx", static_cast<unsigned long long>(location - module.base));
+    buffer += module.name;
+    buffer += text;
+    for (auto offset = offsets.rbegin(); offset != offsets.rend(); ++offset)
+    {
+        std::snprintf(text, sizeof(text), " 0x%llx", static_cast<unsigned long long>(*offset));
+        buffer += text;
+    }
+    buffer += '\n';
+
+    if (buffer.size() >= flushBytes)
+    {
+        flush(state, buffer);
+    }
+
+    return true;
+}
+
+void PointerScanner::flush(SearchState& state, std::string& buffer)
+{
+    std::lock_guard<std::mutex> lock(state.outMutex);
+
+    state.out << buffer;
+    buffer.clear();
+}
+
+/**
+ * \brief Find every pointer to at most maxOffset bytes below node.addr. Static ones end a path, the others become
+ * children one level deeper as long as maxDepth isn't reached.
+ */
+void PointerScanner::expand(const PathNode& node, SearchState& state, std::string& buffer,
+                            std::vector<PathNode>& children)
+{
+    auto range = m_map.find(node.addr < state.maxOffset ? 0 : node.addr - state.maxOffset, node.addr);
+
+    for (size_t i = range.first; i < range.second; i++)
+    {
+        uintptr_t location = m_map.locations()[i];
+        PathNode child {location, node.offsets};
+
+        child.offsets.push_back(node.addr - m_map.values()[i]);
+        if (const Module* module = findModule(location))
+        {
+            if (!emitPath(*module, location, child.offsets, state, buffer))
+            {
+                return;
+            }
+        }
+        else if (static_cast<int>(child.offsets.size()) < state.maxDepth)
+        {
+            children.push_back(std::move(child));
+        }
+    }
+}
+
+/**
+ * \brief Depth first search below addr. offsets is used as a stack, so nothing is allocated per level.
+ */
+void PointerScanner::search(uintptr_t addr, std::vector<size_t>& offsets, SearchState& state, std::string& buffer)
+{
+    auto range = m_map.find(addr < state.maxOffset ? 0 : addr - state.maxOffset, addr);
+
+    for (size_t i = range.first; i < range.second && state.found < state.maxResults; i++)
+    {
+        uintptr_t location = m_map.locations()[i];
+
+        offsets.push_back(addr - m_map.values()[i]);
+        if (const Module* module = findModule(location))
+        {
+            emitPath(*module, location, offsets, state, buffer);
+        }
+        else if (static_cast<int>(offsets.size()) < state.maxDepth)
+        {
+            search(location, offsets, state, buffer);
+        }
+        offsets.pop_back();
+    }
+}
+
+/**
+ * \brief Write all pointer paths of at most maxDepth levels from a module to target.
+ *
+ * The first levels are expanded breadth first until there are enough subtrees to keep every worker busy, the
+ * subtrees are then searched depth first in parallel. Paths are written in no particular order.
+ * \return Number of paths written
+ */
+size_t PointerScanner::scan(uintptr_t target, int maxDepth, size_t maxOffset, std::ostream& out, size_t maxResults)
+{
+    SearchState state {maxDepth, maxOffset, maxResults, {0}, {}, out};
+    std::vector<std::string> buffers(m_pool.threadCount());
+    std::vector<PathNode> frontier {{target, {}}};
+    const size_t minSubtrees = 8 * m_pool.threadCount();
+    int depth = 0;
+
+    out << "# memscan pointer paths to 0x" << std::hex << target << ", depth " << std::dec << maxDepth
+        << ", offset 0x" << std::hex << maxOffset << std::dec << "\n";
+
+    while (!frontier.empty() && frontier.size() < minSubtrees && depth < maxDepth)
+    {
+        std::vector<PathNode> children;
+
+        for (auto& node : frontier)
+        {
+            expand(node, state, buffers[0], children);
+        }
+        frontier.swap(children);
+        depth++;
+    }
+
+    m_pool.run(frontier.size(), [&](size_t task, int worker)
+    {
+        std::vector<size_t> offsets = frontier[task].offsets;
+        search(frontier[task].addr, offsets, state, buffers[worker]);
+    });
+
+    for (auto& buffer : buffers)
+    {
+        flush(state, buffer);
+    }
+    out.flush();
+
+    return std::min<size_t>(state.found, maxResults);
+}
\ No newline at end of file
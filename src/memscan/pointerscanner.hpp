@@ -0,0 +1,113 @@
+#pragma once
+#include "process.hpp"
+#include "scansession.hpp"
+#include "threadpool.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief Reverse pointer map of a process: every aligned pointer sized value that points into a writable region,
+ * sorted by value, together with the address it was found at.
+ *
+ * Values and locations are separate arrays so that lookups only touch values. Every indexStride-th value is sampled
+ * into an index small enough to stay in cache, which narrows a lookup down to one run of indexStride values.
+ * \param pHandle Process handle
+ * \param pool Thread pool used for filtering and sorting
+ */
+class PointerMap
+{
+    public:
+        PointerMap(ProcessHandle pHandle, ThreadPool& pool);
+
+        std::pair<size_t, size_t> find(uintptr_t low, uintptr_t high) const;
+
+        size_t size() const { return m_values.size(); }
+
+        const std::vector<uintptr_t>& values()    const { return m_values; }
+        const std::vector<uintptr_t>& locations() const { return m_locations; }
+
+        const static inline size_t indexStride = 256;
+
+    private:
+        struct Entry
+        {
+            uintptr_t value;
+            uintptr_t location;
+
+            bool operator<(const Entry& other) const { return value < other.value; }
+        };
+
+        std::vector<uintptr_t> m_values;
+        std::vector<uintptr_t> m_locations;
+        std::vector<uintptr_t> m_index;
+
+        size_t lowerBound(uintptr_t val) const;
+        void merge(std::vector<std::vector<Entry>>& found, ThreadPool& pool);
+};
+
+/**
+ * \brief Finds pointer paths from static module data to an address, so that the address can be found again after the
+ * target restarts.
+ *
+ * The pointer map is built once when the scanner is created and reused by every scan. A scan walks the map backwards
+ * from the target: every pointer to at most maxOffset bytes below an address is one more level of the path. Paths are
+ * written as text lines, one per path, as soon as they are found:
+ *
+ *     module+0x2010 0x18 0x0
+ *
+ * reads the pointer at offset 0x2010 of the module, adds 0x18, dereferences that and adds 0x0 to get the target.
+ * \param session Scan session, shared with the Scanner
+ * \param pool Thread pool used for building the map and searching
+ */
+class PointerScanner
+{
+    public:
+        PointerScanner(std::shared_ptr<ScanSession> session, ThreadPool& pool);
+
+        size_t scan(uintptr_t target, int maxDepth, size_t maxOffset, std::ostream& out,
+                    size_t maxResults = defaultMaxResults);
+
+        const PointerMap&          pointerMap() const { return m_map; }
+        const std::vector<Module>& modules()    const { return m_modules; }
+
+        const static inline size_t defaultMaxResults = 1000000;
+        // per-worker output is written once it grows past this
+        const static inline size_t flushBytes = 64 << 10;
+
+    private:
+        struct PathNode
+        {
+            uintptr_t addr;
+            std::vector<size_t> offsets;
+        };
+
+        struct SearchState
+        {
+            int maxDepth;
+            size_t maxOffset;
+            size_t maxResults;
+            std::atomic<size_t> found;
+            std::mutex outMutex;
+            std::ostream& out;
+        };
+
+        std::shared_ptr<ScanSession> m_session;
+        ThreadPool& m_pool;
+        std::vector<Module> m_modules;
+        PointerMap m_map;
+
+        const Module* findModule(uintptr_t addr) const;
+        bool emitPath(const Module& module, uintptr_t location, const std::vector<size_t>& offsets, SearchState& state,
+                      std::string& buffer);
+        void flush(SearchState& state, std::string& buffer);
+        void expand(const PathNode& node, SearchState& state, std::string& buffer, std::vector<PathNode>& children);
+        void search(uintptr_t addr, std::vector<size_t>& offsets, SearchState& state, std::string& buffer);
+};
\ No newline at end of file
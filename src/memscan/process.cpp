@@ -0,0 +1,426 @@
+#include "process.hpp"
+
+#ifdef _WIN32
+#include <memoryapi.h>
+#include <processthreadsapi.h>
+#include <psapi.h>
+#include <winerror.h>
+#else
+#include <signal.h>
+#include <sys/uio.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#ifdef _WIN32
+
+ProcessHandle Process::open(int processId)
+{
+    return OpenProcess(PROCESS_ALL_ACCESS, false, processId);
+}
+
+bool Process::isValid(ProcessHandle pHandle)
+{
+    return pHandle != nullptr;
+}
+
+void Process::close(ProcessHandle pHandle)
+{
+    CloseHandle(pHandle);
+}
+
+/**
+ * \brief Check if BASIC_MEMORY_INFORMATION protect condition allows for reading and writing to memory location
+ * \param protectCond Value of BASIC_MEMORY_INFORMATION.protect (DWORD i.e. int32)
+ * \return Boolean
+ */
+bool Process::checkPage(int32_t protectCond)
+{
+    auto condIter = std::find(writable.begin(), writable.end(), protectCond);
+    return condIter != writable.end() ? true : false;
+}
+
+std::vector<Region> Process::writableRegions(ProcessHandle pHandle)
+{
+    std::vector<Region> regions;
+    MEMORY_BASIC_INFORMATION memInfo;
+    char* addr = 0;
+
+    while (1)
+    {
+        SIZE_T byteCount = VirtualQueryEx(pHandle, addr, &memInfo, sizeof(memInfo));
+        if (byteCount == 0 || byteCount == ERROR_INVALID_PARAMETER)
+        {
+            break;
+        }
+        if ((memInfo.State & MEM_COMMIT) && (checkPage(memInfo.Protect)))
+        {
+            Region region {static_cast<char*>(memInfo.BaseAddress), memInfo.RegionSize};
+            char path[MAX_PATH] = {0};
+
+            // heaps and stacks are private memory like any other allocation, there is no telling them apart here
+            if (memInfo.Type == MEM_IMAGE || memInfo.Type == MEM_MAPPED)
+            {
+                region.kind = memInfo.Type == MEM_IMAGE ? REGION_IMAGE : REGION_FILE;
+                if (GetMappedFileNameA(pHandle, memInfo.BaseAddress, path, sizeof(path)))
+                {
+                    region.path = path;
+                }
+            }
+            regions.push_back(region);
+        }
+
+        addr = static_cast<char*>(memInfo.BaseAddress) + memInfo.RegionSize;
+    }
+
+    return regions;
+}
+
+/**
+ * \brief List the executable and all loaded DLLs, sorted by base address
+ */
+std::vector<Module> Process::modules(ProcessHandle pHandle)
+{
+    std::vector<Module> modules;
+    std::vector<HMODULE> handles(1024);
+    DWORD bytesNeeded = 0;
+
+    if (!EnumProcessModulesEx(pHandle, handles.data(), handles.size() * sizeof(HMODULE), &bytesNeeded, 
+                              LIST_MODULES_ALL))
+    {
+        return modules;
+    }
+    handles.resize(std::min<size_t>(handles.size(), bytesNeeded / sizeof(HMODULE)));
+
+    for (auto handle : handles)
+    {
+        MODULEINFO info;
+        char name[MAX_PATH] = {0};
+
+        if (GetModuleInformation(pHandle, handle, &info, sizeof(info)))
+        {
+            GetModuleBaseNameA(pHandle, handle, name, sizeof(name));
+            modules.push_back({name, reinterpret_cast<uintptr_t>(info.lpBaseOfDll), info.SizeOfImage});
+        }
+    }
+    std::sort(modules.begin(), modules.end(), [](const Module& a, const Module& b) { return a.base < b.base; });
+
+    return modules;
+}
+
+size_t Process::read(ProcessHandle pHandle, const void* addr, void* buffer, size_t size)
+{
+    SIZE_T bytesRead = 0;
+
+    ReadProcessMemory(pHandle, addr, buffer, size, &bytesRead);
+    return bytesRead;
+}
+
+/**
+ * \brief Read every request. Windows has no vectored variant of ReadProcessMemory so this is one call per request.
+ * \param requests Requests to read, bytesRead of each is updated
+ */
+void Process::readBatch(ProcessHandle pHandle, std::vector<ReadRequest>& requests)
+{
+    for (auto& req : requests)
+    {
+        req.bytesRead = read(pHandle, req.addr, req.buffer, req.size);
+    }
+}
+
+bool Process::write(ProcessHandle pHandle, uintptr_t addr, const void* buffer, size_t size)
+{
+    return WriteProcessMemory(pHandle, reinterpret_cast<void*>(addr), buffer, size, nullptr);
+}
+
+/**
+ * \brief Write every request, one call per request. Callers sort the requests by address, so that consecutive calls
+ * stay within the same region.
+ * \param requests Requests to write, bytesWritten of each is updated
+ */
+void Process::writeBatch(ProcessHandle pHandle, std::vector<WriteRequest>& requests)
+{
+    for (auto& req : requests)
+    {
+        SIZE_T bytesWritten = 0;
+
+        WriteProcessMemory(pHandle, req.addr, req.buffer, req.size, &bytesWritten);
+        req.bytesWritten = bytesWritten;
+    }
+}
+
+#else
+
+/**
+ * \brief Linux processes don't need to be opened, the pid itself acts as handle.
+ * \return Process id or 0 if no such process exists
+ */
+ProcessHandle Process::open(int processId)
+{
+    if (processId <= 0 || (kill(processId, 0) != 0 && errno != EPERM))
+    {
+        return 0;
+    }
+
+    return processId;
+}
+
+bool Process::isValid(ProcessHandle pHandle)
+{
+    return pHandle > 0;
+}
+
+void Process::close(ProcessHandle)
+{}
+
+/**
+ * \brief Parse /proc/<pid>/maps and collect all readable + writable mappings. Files that are also mapped executable
+ * are modules, their mappings and the anonymous mapping right behind them (the .bss) are REGION_IMAGE.
+ */
+std::vector<Region> Process::writableRegions(ProcessHandle pHandle)
+{
+    std::vector<Region> regions;
+    std::vector<std::string> lines;
+    std::vector<std::string> images;
+    std::ifstream maps("/proc/" + std::to_string(pHandle) + "/maps");
+    std::string line;
+
+    while (std::getline(maps, line))
+    {
+        char perms[5] = {0};
+        int pathStart = 0;
+
+        if (std::sscanf(line.c_str(), "%*x-%*x %4s %*s %*s %*s %n", perms, &pathStart) == 1 && pathStart > 0 &&
+            perms[2] == 'x' && line[pathStart] == '/')
+        {
+            images.push_back(line.substr(pathStart));
+        }
+        lines.push_back(line);
+    }
+
+    std::string lastPath;
+    for (auto& mapping : lines)
+    {
+        unsigned long long start;
+        unsigned long long end;
+        char perms[5] = {0};
+        int pathStart = 0;
+
+        if (std::sscanf(mapping.c_str(), "%llx-%llx %4s %*s %*s %*s %n", &start, &end, perms, &pathStart) != 3)
+        {
+            continue;
+        }
+
+        std::string path = pathStart > 0 ? mapping.substr(pathStart) : "";
+        bool isImage = !path.empty() && std::find(images.begin(), images.end(), path) != images.end();
+        bool isBss = path.empty() && !regions.empty() && regions.back().kind == REGION_IMAGE &&
+                     regions.back().addr + regions.back().size == reinterpret_cast<char*>(start) && 
+                     regions.back().path == lastPath;
+
+        lastPath = path;
+        if (perms[0] != 'r' || perms[1] != 'w' || end <= start)
+        {
+            continue;
+        }
+
+        Region region {reinterpret_cast<char*>(start), static_cast<size_t>(end - start)};
+        if (isImage || isBss)
+        {
+            region.kind = REGION_IMAGE;
+            region.path = isBss ? regions.back().path : path;
+        }
+        else if (path == "[heap]")
+        {
+            region.kind = REGION_HEAP;
+        }
+        else if (path.compare(0, 6, "[stack") == 0)
+        {
+            region.kind = REGION_STACK;
+        }
+        else if (!path.empty() && path[0] == '/')
+        {
+            region.kind = REGION_FILE;
+            region.path = path;
+        }
+        regions.push_back(region);
+    }
+
+    return regions;
+}
+
+/**
+ * \brief Collect the file backed mappings of /proc/<pid>/maps. Consecutive mappings of the same file are one module, 
+ * named after the file, and so is the anonymous mapping right behind it that holds its .bss. Sorted by base address, 
+ * like the maps file.
+ */
+std::vector<Module> Process::modules(ProcessHandle pHandle)
+{
+    std::vector<Module> modules;
+    std::ifstream maps("/proc/" + std::to_string(pHandle) + "/maps");
+    std::string line;
+    // only the mapping right after a file mapping can be its .bss
+    bool afterFile = false;
+
+    while (std::getline(maps, line))
+    {
+        unsigned long long start;
+        unsigned long long end;
+        int pathStart = 0;
+
+        if (std::sscanf(line.c_str(), "%llx-%llx %*s %*s %*s %*s %n", &start, &end, &pathStart) != 2 || 
+            pathStart == 0)
+        {
+            continue;
+        }
+
+        std::string path = line.substr(pathStart);
+        bool extends = !modules.empty() && modules.back().base + modules.back().size <= start;
+        bool bss = afterFile && path.empty() && modules.back().base + modules.back().size == start;
+
+        afterFile = !path.empty() && path[0] == '/';
+        if (bss)
+        {
+            modules.back().size = end - modules.back().base;
+        }
+        else if (afterFile)
+        {
+            std::string name = path.substr(path.rfind('/') + 1);
+
+            if (extends && modules.back().name == name)
+            {
+                modules.back().size = end - modules.back().base;
+            }
+            else
+            {
+                modules.push_back({name, static_cast<uintptr_t>(start), static_cast<size_t>(end - start)});
+            }
+        }
+    }
+
+    return modules;
+}
+
+size_t Process::read(ProcessHandle pHandle, const void* addr, void* buffer, size_t size)
+{
+    iovec local {buffer, size};
+    iovec remote {const_cast<void*>(addr), size};
+
+    ssize_t bytesRead = process_vm_readv(pHandle, &local, 1, &remote, 1, 0);
+    return bytesRead > 0 ? bytesRead : 0;
+}
+
+/**
+ * \brief Read all requests with as few process_vm_readv calls as possible.
+ *
+ * The kernel stops at the first remote iovec it can't read, so on a short read the request it stopped at is marked
+ * (partially) read and the batch continues from the one after it.
+ * \param requests Requests to read, bytesRead of each is updated
+ */
+void Process::readBatch(ProcessHandle pHandle, std::vector<ReadRequest>& requests)
+{
+    std::vector<iovec> local;
+    std::vector<iovec> remote;
+    size_t first = 0;
+
+    while (first < requests.size())
+    {
+        size_t count = std::min(requests.size() - first, maxIovecs);
+
+        local.resize(count);
+        remote.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            local[i] = {requests[first+i].buffer, requests[first+i].size};
+            remote[i] = {requests[first+i].addr, requests[first+i].size};
+        }
+
+        ssize_t bytesRead = process_vm_readv(pHandle, local.data(), count, remote.data(), count, 0);
+        if (bytesRead < 0 && (errno == ESRCH || errno == EPERM))
+        {
+            for (size_t i = first; i < requests.size(); i++)
+            {
+                requests[i].bytesRead = 0;
+            }
+            return;
+        }
+
+        size_t left = bytesRead > 0 ? bytesRead : 0;
+        size_t i = first;
+        while (i < first+count && left >= requests[i].size)
+        {
+            requests[i].bytesRead = requests[i].size;
+            left -= requests[i].size;
+            i++;
+        }
+        if (i < first+count)
+        {
+            requests[i].bytesRead = left;
+            i++;
+        }
+        first = i;
+    }
+}
+
+bool Process::write(ProcessHandle pHandle, uintptr_t addr, const void* buffer, size_t size)
+{
+    iovec local {const_cast<void*>(buffer), size};
+    iovec remote {reinterpret_cast<void*>(addr), size};
+
+    return process_vm_writev(pHandle, &local, 1, &remote, 1, 0) == static_cast<ssize_t>(size);
+}
+
+/**
+ * \brief Write all requests with as few process_vm_writev calls as possible. Like readBatch, a short write marks the
+ * request it stopped at and the batch continues from the one after it.
+ * \param requests Requests to write, bytesWritten of each is updated
+ */
+void Process::writeBatch(ProcessHandle pHandle, std::vector<WriteRequest>& requests)
+{
+    std::vector<iovec> local;
+    std::vector<iovec> remote;
+    size_t first = 0;
+
+    while (first < requests.size())
+    {
+        size_t count = std::min(requests.size() - first, maxIovecs);
+
+        local.resize(count);
+        remote.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            local[i] = {const_cast<char*>(requests[first+i].buffer), requests[first+i].size};
+            remote[i] = {requests[first+i].addr, requests[first+i].size};
+        }
+
+        ssize_t bytesWritten = process_vm_writev(pHandle, local.data(), count, remote.data(), count, 0);
+        if (bytesWritten < 0 && (errno == ESRCH || errno == EPERM))
+        {
+            for (size_t i = first; i < requests.size(); i++)
+            {
+                requests[i].bytesWritten = 0;
+            }
+            return;
+        }
+
+        size_t left = bytesWritten > 0 ? bytesWritten : 0;
+        size_t i = first;
+        while (i < first+count && left >= requests[i].size)
+        {
+            requests[i].bytesWritten = requests[i].size;
+            left -= requests[i].size;
+            i++;
+        }
+        if (i < first+count)
+        {
+            requests[i].bytesWritten = left;
+            i++;
+        }
+        first = i;
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+#ifdef _WIN32
+#include <handleapi.h>
+#else
+#include <sys/types.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+typedef HANDLE ProcessHandle;
+#else
+typedef pid_t ProcessHandle;
+#endif
+
+/**
+ * \brief What a region is mapped for. Values are bits, so that RegionFilter can hold a set of kinds.
+ */
+enum RegionKind
+{
+    REGION_ANON = 1,
+    REGION_HEAP = 2,
+    REGION_STACK = 4,
+    REGION_FILE = 8,
+    REGION_IMAGE = 16
+};
+
+/**
+ * \brief Writable memory region of a process. path is the mapped file of REGION_FILE and REGION_IMAGE regions, the
+ * .bss of a module is a REGION_IMAGE with the path of the module.
+ */
+struct Region
+{
+    char* addr;
+    size_t size;
+    RegionKind kind = REGION_ANON;
+    std::string path = "";
+};
+
+/**
+ * \brief Executable or library mapped into a process. Its writable regions hold the static data of the module.
+ */
+struct Module
+{
+    std::string name;
+    uintptr_t base;
+    size_t size;
+};
+
+/**
+ * \brief Single remote read of a batch. bytesRead is filled by Process::readBatch.
+ */
+struct ReadRequest
+{
+    char* addr;
+    char* buffer;
+    size_t size;
+    size_t bytesRead;
+};
+
+/**
+ * \brief Single remote write of a batch. bytesWritten is filled by Process::writeBatch.
+ */
+struct WriteRequest
+{
+    char* addr;
+    const char* buffer;
+    size_t size;
+    size_t bytesWritten;
+};
+
+/**
+ * \brief Platform layer for process memory access.
+ *
+ * Windows uses VirtualQueryEx + ReadProcessMemory/WriteProcessMemory, Linux uses /proc/<pid>/maps +
+ * process_vm_readv/process_vm_writev.
+ */
+class Process
+{
+    public:
+        static ProcessHandle open(int processId);
+        static bool isValid(ProcessHandle pHandle);
+        static void close(ProcessHandle pHandle);
+        static std::vector<Region> writableRegions(ProcessHandle pHandle);
+        static std::vector<Module> modules(ProcessHandle pHandle);
+        static size_t read(ProcessHandle pHandle, const void* addr, void* buffer, size_t size);
+        static void readBatch(ProcessHandle pHandle, std::vector<ReadRequest>& requests);
+        static bool write(ProcessHandle pHandle, uintptr_t addr, const void* buffer, size_t size);
+        static void writeBatch(ProcessHandle pHandle, std::vector<WriteRequest>& requests);
+
+#ifdef _WIN32
+        bool static checkPage(int32_t protectCond);
+
+        const static inline std::vector<int> writable {PAGE_READWRITE, PAGE_WRITECOPY, PAGE_EXECUTE_READWRITE,
+                                                       PAGE_EXECUTE_WRITECOPY};
+#else
+        // process_vm_readv/writev accept at most IOV_MAX (1024) iovecs per call
+        const static inline size_t maxIovecs = 1024;
+#endif
+};
\ No newline at end of file
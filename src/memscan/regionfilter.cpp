@@ -0,0 +1,235 @@
+#include "regionfilter.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+    std::string toLower(std::string s)
+    {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+        return s;
+    }
+
+    /**
+     * \brief Parse a size with an optional k, m or g suffix
+     */
+    bool parseSize(const std::string& s, size_t& size)
+    {
+        char* end = nullptr;
+        unsigned long long value = std::strtoull(s.c_str(), &end, 0);
+        std::string suffix = toLower(end);
+
+        if (end == s.c_str() || suffix.size() > 1)
+        {
+            return false;
+        }
+
+        int shift = suffix == "k" ? 10 : suffix == "m" ? 20 : suffix == "g" ? 30 : 0;
+        if (!suffix.empty() && shift == 0)
+        {
+            return false;
+        }
+        size = static_cast<size_t>(value) << shift;
+        return true;
+    }
+}
+
+RegionFilter::RegionFilter()
+    : m_includeKinds(0)
+    , m_excludeKinds(0)
+    , m_minSize(0)
+    , m_maxSize(std::numeric_limits<size_t>::max())
+{}
+
+/**
+ * \brief Add the terms of spec to the filter
+ * \param error The term that couldn't be parsed
+ * \return False if a term is invalid
+ */
+bool RegionFilter::parse(const std::string& spec, std::string& error)
+{
+    std::istringstream terms(spec);
+    std::string term;
+
+    while (terms >> term)
+    {
+        bool exclude = term[0] == '-';
+        std::string body = exclude ? term.substr(1) : term;
+        size_t colon = body.find(':');
+        std::string name = toLower(body.substr(0, colon));
+        std::string value = colon == std::string::npos ? "" : body.substr(colon + 1);
+        unsigned kind = name == "anon" ? REGION_ANON : name == "heap" ? REGION_HEAP : name == "stack" ? REGION_STACK
+                      : name == "file" ? REGION_FILE : name == "image" ? REGION_IMAGE : 0;
+
+        if (kind != 0 && colon == std::string::npos)
+        {
+            (exclude ? m_excludeKinds : m_includeKinds) |= kind;
+        }
+        else if (name == "module" && !value.empty())
+        {
+            (exclude ? m_excludeModules : m_includeModules).push_back(toLower(value));
+        }
+        else if (name == "range")
+        {
+            size_t dash = value.find('-');
+            char* end = nullptr;
+            char* end2 = nullptr;
+            std::string low = value.substr(0, dash);
+            std::string high = dash == std::string::npos ? "" : value.substr(dash + 1);
+            uintptr_t lo = std::strtoull(low.c_str(), &end, 0);
+            uintptr_t hi = std::strtoull(high.c_str(), &end2, 0);
+
+            if (low.empty() || high.empty() || *end != '\0' || *end2 != '\0' || lo >= hi)
+            {
+                error = term;
+                return false;
+            }
+
+            // whole pages, so that clipped regions keep the alignment of the values
+            lo = lo / pageSize * pageSize;
+            hi = hi > std::numeric_limits<uintptr_t>::max() - pageSize ? hi : (hi + pageSize - 1) / pageSize * pageSize;
+            (exclude ? m_excludeRanges : m_includeRanges).push_back({lo, hi});
+        }
+        else if ((name == "min" || name == "max") && !exclude)
+        {
+            if (!parseSize(value, name == "min" ? m_minSize : m_maxSize))
+            {
+                error = term;
+                return false;
+            }
+        }
+        else
+        {
+            error = term;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool RegionFilter::isEmpty() const
+{
+    return m_includeKinds == 0 && m_excludeKinds == 0 && m_includeModules.empty() && m_excludeModules.empty() &&
+           m_includeRanges.empty() && m_excludeRanges.empty() && m_minSize == 0 && 
+           m_maxSize == std::numeric_limits<size_t>::max();
+}
+
+/**
+ * \brief Drop the regions that don't pass and cut the rest to the address ranges
+ */
+void RegionFilter::apply(std::vector<Region>& regions) const
+{
+    if (isEmpty())
+    {
+        return;
+    }
+
+    std::vector<Region> kept;
+    for (auto& region : regions)
+    {
+        if (!accepts(region))
+        {
+            continue;
+        }
+
+        std::vector<Region> pieces;
+        if (m_includeRanges.empty())
+        {
+            pieces.push_back(region);
+        }
+        for (auto& range : m_includeRanges)
+        {
+            std::vector<Region> inside {region};
+            clip(inside, range, true);
+            pieces.insert(pieces.end(), inside.begin(), inside.end());
+        }
+        for (auto& range : m_excludeRanges)
+        {
+            clip(pieces, range, false);
+        }
+
+        // overlapping include ranges may have cut the same piece twice
+        std::sort(pieces.begin(), pieces.end(), [](const Region& a, const Region& b) { return a.addr < b.addr; });
+        for (auto& piece : pieces)
+        {
+            if (!kept.empty() && kept.back().addr + kept.back().size > piece.addr)
+            {
+                char* end = std::max(kept.back().addr + kept.back().size, piece.addr + piece.size);
+                kept.back().size = end - kept.back().addr;
+                continue;
+            }
+            kept.push_back(piece);
+        }
+    }
+
+    regions = std::move(kept);
+}
+
+bool RegionFilter::accepts(const Region& region) const
+{
+    return (m_includeKinds == 0 || (m_includeKinds & region.kind)) && !(m_excludeKinds & region.kind) &&
+           (m_includeModules.empty() || matchesModule(region.path, m_includeModules)) &&
+           !matchesModule(region.path, m_excludeModules) && region.size >= m_minSize && region.size <= m_maxSize;
+}
+
+/**
+ * \brief The file name of path is one of modules, which are lower case
+ */
+bool RegionFilter::matchesModule(const std::string& path, const std::vector<std::string>& modules)
+{
+    if (path.empty())
+    {
+        return false;
+    }
+
+    size_t slash = path.find_last_of("/\\");
+    std::string name = toLower(slash == std::string::npos ? path : path.substr(slash + 1));
+    return std::find(modules.begin(), modules.end(), name) != modules.end();
+}
+
+/**
+ * \brief Cut every piece to the part inside range, or cut range out of it
+ */
+void RegionFilter::clip(std::vector<Region>& pieces, const AddressRange& range, bool keepInside)
+{
+    std::vector<Region> result;
+
+    for (auto& piece : pieces)
+    {
+        uintptr_t begin = reinterpret_cast<uintptr_t>(piece.addr);
+        uintptr_t end = begin + piece.size;
+        uintptr_t overlapBegin = std::max(begin, range.first);
+        uintptr_t overlapEnd = std::min(end, range.second);
+        auto add = [&](uintptr_t from, uintptr_t to)
+        {
+            if (from < to)
+            {
+                Region part = piece;
+                part.addr = reinterpret_cast<char*>(from);
+                part.size = to - from;
+                result.push_back(part);
+            }
+        };
+
+        if (keepInside)
+        {
+            add(overlapBegin, overlapEnd);
+        }
+        else if (overlapBegin >= overlapEnd)
+        {
+            result.push_back(piece);
+        }
+        else
+        {
+            add(begin, overlapBegin);
+            add(overlapEnd, end);
+        }
+    }
+
+    pieces = std::move(result);
+}
\ No newline at end of file
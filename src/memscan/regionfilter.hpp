@@ -0,0 +1,50 @@
+#pragma once
+#include "process.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief Picks the regions worth scanning before any MemBlock buffer is allocated.
+ *
+ * A filter is written as terms separated by spaces, e.g. "heap anon -range:0-0x10000 min:64k":
+ * - heap, stack, anon, file, image: only regions of these kinds, -kind leaves a kind out
+ * - module:name: only regions mapped from a file of that name (case is ignored), -module:name leaves them out
+ * - range:lo-hi: only the part of regions within [lo, hi), -range:lo-hi cuts [lo, hi) out of them. Bounds are rounded
+ *   outwards to whole pages.
+ * - min:size, max:size: only regions of at least/at most size bytes, with an optional k, m or g suffix
+ *
+ * Terms of different kinds must all hold, includes of the same kind are alternatives.
+ */
+class RegionFilter
+{
+    public:
+        RegionFilter();
+
+        bool parse(const std::string& spec, std::string& error);
+        void apply(std::vector<Region>& regions) const;
+
+        bool isEmpty() const;
+
+        const static inline unsigned allKinds = REGION_ANON | REGION_HEAP | REGION_STACK | REGION_FILE | REGION_IMAGE;
+        const static inline uintptr_t pageSize = 4096;
+
+    private:
+        typedef std::pair<uintptr_t, uintptr_t> AddressRange;
+
+        unsigned m_includeKinds;
+        unsigned m_excludeKinds;
+        std::vector<std::string> m_includeModules;
+        std::vector<std::string> m_excludeModules;
+        std::vector<AddressRange> m_includeRanges;
+        std::vector<AddressRange> m_excludeRanges;
+        size_t m_minSize;
+        size_t m_maxSize;
+
+        bool accepts(const Region& region) const;
+        static bool matchesModule(const std::string& path, const std::vector<std::string>& modules);
+        static void clip(std::vector<Region>& pieces, const AddressRange& range, bool keepInside);
+};
\ No newline at end of file
@@ -1,47 +1,257 @@
+#include "aobscanner.hpp"
+#include "floatscanner.hpp"
 #include "intscanner.hpp"
+#include "matchpage.hpp"
 #include "memblock.hpp"
+#include "pointerscanner.hpp"
+#include "process.hpp"
 #include "scanner.hpp"
+#include "sessionfile.hpp"
 #include "stringscanner.hpp"
+#include "valueset.hpp"
 
-#include <memoryapi.h>
-#include <processthreadsapi.h>
-#include <winerror.h>
-
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <thread>
+
+Scanner::Scanner(int threadCount, std::chrono::microseconds freezeInterval, size_t maxMatches,
+                 const RegionFilter& regionFilter)
+    : m_pool(threadCount)
+    , m_freezeInterval(freezeInterval)
+    , m_maxMatches(maxMatches)
+    , m_regionFilter(regionFilter)
+    , m_printFirst(0)
+    , m_printTotal(0)
+    , m_pattern("")
+    , m_resumed(false)
+{}
 
-std::vector<MemBlock> Scanner::createScan(int processId, int dataSize) 
+/**
+ * \brief Freezer of the current session, started on first use
+ */
+Freezer& Scanner::freezer()
 {
-    std::vector<MemBlock> mbScan;
-    MEMORY_BASIC_INFORMATION memInfo;
-    char* addr = 0;
+    if (!m_freezer)
+    {
+        m_freezer = std::make_unique<Freezer>(m_scan, m_freezeInterval);
+    }
+
+    return *m_freezer;
+}
 
-    HANDLE pHandle = OpenProcess(PROCESS_ALL_ACCESS, false, processId);
+/**
+ * \brief Ask for an address and the value to hold it at, or list the frozen values if no address is given
+ * \param isFloat Parse the value as float/double instead of integer
+ */
+void Scanner::uiFreeze(bool isFloat)
+{
+    std::string input;
+    char bytes[8] = {0};
+    int dataSize = m_scan->dataSize();
 
-    if (pHandle) 
+    std::cout << "Enter the address (empty lists frozen values): ";
+    std::getline(std::cin, input);
+    if (input.empty())
     {
-        while (1) 
+        for (auto& [addr, value] : freezer().frozen())
         {
-            SIZE_T byteCount = VirtualQueryEx(pHandle, addr, &memInfo, sizeof(memInfo));
-            if (byteCount == 0 || byteCount == ERROR_INVALID_PARAMETER) 
-            {
-                break;
-            }
-            if ((memInfo.State & MEM_COMMIT) && (MemBlock::checkPage(memInfo.Protect))) 
-            {
-                MemBlock mb(pHandle, &memInfo, dataSize);
-                mbScan.insert(mbScan.end(), mb);
-            }
+            std::cout << "\r\n0x" << std::hex << addr << std::dec << " (" << value.size() << " bytes)";
+        }
+        std::cout << "\r\n" << freezer().frozen().size() << " values frozen, " << freezer().failedWrites() 
+            << " failed writes\r\n";
+        return;
+    }
+    uintptr_t addr = stringToInt(input);
+
+    std::cout << "\nEnter the value (empty keeps the current value): ";
+    std::getline(std::cin, input);
+    std::cout << "\r\n";
+
+    if (input.empty())
+    {
+        if (Process::read(m_scan->pHandle(), reinterpret_cast<void*>(addr), bytes, dataSize) != 
+            static_cast<size_t>(dataSize))
+        {
+            std::cout << "Can't read 0x" << std::hex << addr << std::dec << "\r\n";
+            return;
+        }
+    }
+    else if (isFloat && dataSize == 8)
+    {
+        double val = std::strtod(input.c_str(), nullptr);
+        std::memcpy(bytes, &val, sizeof(val));
+    }
+    else if (isFloat)
+    {
+        float val = std::strtof(input.c_str(), nullptr);
+        std::memcpy(bytes, &val, sizeof(val));
+    }
+    else
+    {
+        // little endian, so the low dataSize bytes are the truncated value
+        int64_t val = stringToInt(input);
+        std::memcpy(bytes, &val, sizeof(val));
+    }
+
+    freezer().freeze(addr, bytes, dataSize);
+    std::cout << "0x" << std::hex << addr << std::dec << " frozen\r\n";
+}
+
+void Scanner::uiUnfreeze()
+{
+    std::string input;
+
+    std::cout << "Enter the address (empty unfreezes all): ";
+    std::getline(std::cin, input);
+    std::cout << "\r\n";
+
+    if (input.empty())
+    {
+        freezer().clear();
+    }
+    else
+    {
+        freezer().unfreeze(stringToInt(input));
+    }
+}
+
+/**
+ * \brief Sample a few addresses for a while and show how often each of them changed
+ * \param isFloat Show values as float/double instead of integer
+ */
+void Scanner::uiWatch(bool isFloat)
+{
+    std::string input;
+    std::vector<uintptr_t> addrs;
+    double rate = 100;
+    double seconds = 5;
+    const size_t maxWatched = 64;
+
+    std::cout << "Enter the addresses to watch, comma separated (empty watches the first " << maxWatched 
+        << " matches): ";
+    std::getline(std::cin, input);
+    for (auto addr : stringToIntSet(input))
+    {
+        addrs.push_back(addr);
+    }
+    if (addrs.empty())
+    {
+        addrs = matchAddresses(maxWatched);
+    }
 
-            addr = static_cast<char*>(memInfo.BaseAddress) + memInfo.RegionSize;
+    std::cout << "\nEnter the sample rate in Hz (empty for " << rate << "): ";
+    std::getline(std::cin, input);
+    if (!input.empty())
+    {
+        rate = std::max(std::strtod(input.c_str(), nullptr), 0.001);
+    }
+
+    std::cout << "\nEnter the duration in seconds (empty for " << seconds << "): ";
+    std::getline(std::cin, input);
+    if (!input.empty())
+    {
+        seconds = std::strtod(input.c_str(), nullptr);
+    }
+    std::cout << "\r\n";
+
+    WatchList watchList(m_scan, addrs, isFloat, 1024);
+    watchList.start(std::chrono::microseconds(static_cast<int64_t>(1e6 / rate)));
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    watchList.stop();
+
+    auto printValue = [&](const char* label, int64_t value)
+    {
+        std::cout << label;
+        if (isFloat)
+        {
+            std::cout << watchList.asDouble(value);
+        }
+        else
+        {
+            std::cout << value;
         }
+    };
+
+    for (auto& stats : watchList.stats())
+    {
+        std::cout << "0x" << std::hex << stats.addr << std::dec << " -> changes: " << stats.changes << " of " 
+            << stats.samples << " samples";
+        printValue(" | min: ", stats.min);
+        printValue(" | max: ", stats.max);
+        printValue(" | last: ", stats.last);
+        std::cout << "\r\n";
     }
+}
+
+/**
+ * \brief Print one page of up to m_maxMatches matches with a single write to std::cout.
+ *
+ * The command alone continues after the previous page, or starts over once the matches changed or all were shown.
+ * A number right after the command letter (e.g. m200) starts the page at that match. Values are read fresh with one
+ * batch, the value of the last scan is added where it differs.
+ * \param command Command as typed by the user
+ * \param valueSize Bytes per value
+ * \param hasSnapshot The MemBlock buffers hold the values of the last scan
+ * \param format Appends a value to the text
+ */
+void Scanner::uiPrintMatches(std::vector<MemBlock>& memblocks, const std::string& command, size_t valueSize, 
+                             bool hasSnapshot, const ValueFormatter& format)
+{
+    size_t total = getMatchesCount(memblocks);
+    std::string text;
+    char addr[32];
 
-    return mbScan;
-};
+    if (command.size() > 1)
+    {
+        m_printFirst = std::max(stringToInt(command.substr(1)), 0LL);
+    }
+    else if (total != m_printTotal || m_printFirst >= total)
+    {
+        m_printFirst = 0;
+    }
 
-int Scanner::getMatchesCount(std::vector<MemBlock>& mbScan) 
+    MatchPage page(m_scan->pHandle(), memblocks, m_printFirst, m_maxMatches, valueSize, hasSnapshot);
+    for (auto& entry : page.entries())
+    {
+        std::snprintf(addr, sizeof(addr), "0x%llx", static_cast<unsigned long long>(entry.addr));
+        text += addr;
+        text += " -> value: ";
+        if (entry.current)
+        {
+            format(text, entry.current);
+        }
+        else
+        {
+            text += "unreadable";
+        }
+        if (entry.current && entry.snapshot && std::memcmp(entry.current, entry.snapshot, valueSize) != 0)
+        {
+            text += " (scanned: ";
+            format(text, entry.snapshot);
+            text += ")";
+        }
+        text += " | size: " + std::to_string(entry.block->size()) + "\r\n";
+    }
+
+    if (page.entries().size() < total)
+    {
+        text += "matches " + std::to_string(m_printFirst + 1) + " to " + 
+            std::to_string(m_printFirst + page.entries().size()) + " of " + std::to_string(total) + 
+            ", repeat the command for the next page\r\n";
+    }
+    m_printFirst += page.entries().size();
+    m_printTotal = total;
+
+    std::cout << text << std::flush;
+}
+
+size_t Scanner::getMatchesCount(std::vector<MemBlock>& mbScan) 
 {
-    int count = 0;
+    size_t count = 0;
 
     for (auto& mb : mbScan) 
     {
@@ -51,6 +261,36 @@ int Scanner::getMatchesCount(std::vector<MemBlock>& mbScan)
     return count;
 }
 
+/**
+ * \brief Addresses of the first limit matches of the current scan
+ */
+std::vector<uintptr_t> Scanner::matchAddresses(size_t limit)
+{
+    std::vector<uintptr_t> addrs;
+
+    for (auto& mb : m_scan->memblocks())
+    {
+        if (mb.isSparse())
+        {
+            for (size_t i = 0; i < mb.sparseMatches().size() && addrs.size() < limit; i++)
+            {
+                addrs.push_back(mb.sparseMatches()[i].addr);
+            }
+            continue;
+        }
+
+        for (size_t offset = 0; offset + mb.dataSize() <= mb.size() && addrs.size() < limit; offset += mb.stride())
+        {
+            if (mb.isInSearch(offset))
+            {
+                addrs.push_back(reinterpret_cast<uintptr_t>(mb.addr()) + offset);
+            }
+        }
+    }
+
+    return addrs;
+}
+
 long long Scanner::stringToInt(std::string s)
 {
     int base = 10;
@@ -87,83 +327,220 @@ long long Scanner::stringToInt(std::string s)
     return stoll(s, nullptr, base);
 }
 
+/**
+ * \brief Parse an integer value. "lo..hi" matches every value from lo to hi, anything else the value itself.
+ * \return COND_BETWEEN with the bounds in val and val2, or COND_EQUALS with the value in val
+ */
+Condition Scanner::stringToIntCondition(std::string s, int64_t& val, int64_t& val2)
+{
+    size_t dots = s.find("..");
+
+    if (dots != std::string::npos)
+    {
+        val = stringToInt(s.substr(0, dots));
+        val2 = stringToInt(s.substr(dots + 2));
+        return COND_BETWEEN;
+    }
+
+    val = stringToInt(s);
+    val2 = 0;
+    return COND_EQUALS;
+}
+
+/**
+ * \brief Parse a comma separated list of integer values, e.g. "100,0x20,-5"
+ */
+std::vector<int64_t> Scanner::stringToIntSet(const std::string& s)
+{
+    std::vector<int64_t> values;
+    size_t begin = 0;
+
+    while (begin <= s.size())
+    {
+        size_t comma = std::min(s.find(',', begin), s.size());
+
+        if (comma > begin)
+        {
+            values.push_back(stringToInt(s.substr(begin, comma - begin)));
+        }
+        begin = comma + 1;
+    }
+
+    return values;
+}
+
 StringScanner Scanner::createStringScanner(Condition startCondition)
 {
-    StringScanner strScanner(m_scan);
-    strScanner.updateScan(startCondition, m_strVal);
-    m_scan = strScanner.memblocks();
+    StringScanner strScanner(m_scan, m_pool, m_strEncoding, m_ignoreCase);
+    if (!m_resumed)
+    {
+        strScanner.updateScan(startCondition, m_strVal);
+    }
 
-    std::cout << "\r\n" << getMatchesCount(m_scan) << " matches found\n";
     return strScanner;
 }
 
 IntScanner Scanner::createIntScanner(Condition startCondition)
 {
-    IntScanner intScan(m_scan);
-    intScan.updateScan(startCondition, m_intVal);
-    m_scan = intScan.memblocks();
+    IntScanner intScan(m_scan, m_pool);
+
+    if (m_resumed)
+    {
+        return intScan;
+    }
+    if (!m_intSet.empty())
+    {
+        ValueSet set(m_intSet, intScan.dataSize());
+
+        // shown by openIntUi, the set drops values that don't fit the data size
+        m_setHits = intScan.updateScanSet(set);
+        m_intSet = set.values();
+        return intScan;
+    }
+    intScan.updateScan(startCondition, m_intVal, m_intVal2);
 
-    std::cout << "\r\n" << getMatchesCount(m_scan) << " matches found\n";
     return intScan;
 }
 
+FloatScanner Scanner::createFloatScanner(Condition startCondition)
+{
+    FloatScanner floatScan(m_scan, m_pool);
+    if (!m_resumed)
+    {
+        floatScan.updateScan(startCondition, m_floatRange);
+    }
+
+    return floatScan;
+}
+
+AobScanner Scanner::createAobScanner()
+{
+    AobScanner aobScan(m_scan, m_pool);
+    if (!m_resumed)
+    {
+        aobScan.updateScan(m_pattern);
+    }
+
+    return aobScan;
+}
+
 // UI
 void Scanner::uiNewScan()
 {
-    DWORD pId;
+    int pId;
     int dataSize;
     std::string input;
 
+    // drop the previous session before allocating the next one, frozen values belong to it
+    m_freezer.reset();
+    m_scan.reset();
+    m_resumed = false;
     while(1)
     {
-        std::cout << "\r\nEnter the process id (or type [tasklist] to display all running tasks): ";
+        std::cout << "\r\nEnter the process id (or type [tasklist] to display all running tasks, <file to resume a "
+                     "saved session): ";
         std::getline(std::cin, input);
+        if (!input.empty() && input[0] == '<')
+        {
+            if (uiLoadSession(input.substr(1)))
+            {
+                break;
+            }
+            std::cout << "\r\nInvalid session";
+            continue;
+        }
         if (input == "tasklist")
         {
+#ifdef _WIN32
             system("tasklist");
+#else
+            system("ps -e -o pid,comm");
+#endif
             continue;
         }
         pId = stringToInt(input);
 
-        std::cout << "\r\nEnter the data size (1/2/4/8 for integers, s for strings. Empty input means 4): ";
+        std::cout << "\r\nEnter the data size (1/2/4/8 for integers, f/d for float/double, add u to also find "
+                     "unaligned values e.g. 4u, s for UTF-8 strings, w for UTF-16 strings, add i to ignore case e.g. "
+                     "wi, a for byte patterns. Empty input means 4): ";
         std::getline(std::cin, input);
-        if (input[0] == 's')
+        m_unaligned = false;
+        if (!input.empty() && input.back() == 'u')
+        {
+            m_unaligned = true;
+            input.pop_back();
+        }
+        if (input[0] == 's' || input[0] == 'w')
+        {
+            m_scanType = SCAN_STRING;
+            m_strEncoding = (input[0] == 'w') ? ENC_UTF16LE : ENC_UTF8;
+            m_ignoreCase = (input.find('i') != std::string::npos);
+            m_unaligned = false;
+            dataSize = 1;
+        }
+        else if (input[0] == 'a')
+        {
+            m_scanType = SCAN_AOB;
+            m_unaligned = false;
+            dataSize = 1;
+        }
+        else if (input[0] == 'f' || input[0] == 'd')
         {
-            m_isString = true;
+            m_scanType = SCAN_FLOAT;
+            dataSize = (input[0] == 'd') ? 8 : 4;
         }
         else
         {
-            m_isString = false;
+            m_scanType = SCAN_INT;
             dataSize = stringToInt(input);
-            if (dataSize == -1)
+            if (dataSize != 1 && dataSize != 2 && dataSize != 8)
             {   
                 dataSize = 4;
             }
         }
 
-        std::cout << "\r\nEnter the start value, or empty input to search all values: ";
+        std::cout << "\r\nEnter the start value (lo..hi for a range, a,b,c for a set of integers, floats: v rounded, =v exact, v~e within e, byte "
+                     "patterns: 48 8B ?? 05), or empty input to search all values: ";
         std::getline(std::cin, input);
+        if (m_scanType == SCAN_AOB)
+        {
+            m_pattern = AobPattern(input);
+            if (!m_pattern.isValid())
+            {
+                std::cout << "\r\nInvalid pattern";
+                continue;
+            }
+        }
         if (input.size() == 0)
         {
             m_startCondition = COND_UNCONDITIONAL;
             m_intVal = 0;
+            m_intVal2 = 0;
+            m_intSet.clear();
+            m_floatRange = FloatRange::exact(0);
             m_strVal = "";
         }
         else
         {
             m_startCondition = COND_EQUALS;
-            if (m_isString)
+            if (m_scanType == SCAN_STRING)
             {
                 m_strVal = input.data();
             }
+            else if (m_scanType == SCAN_FLOAT)
+            {
+                m_floatRange = FloatRange::parse(input, dataSize);
+            }
             else
             {
-                m_intVal = stringToInt(input);
+                m_startCondition = stringToIntCondition(input, m_intVal, m_intVal2);
+                m_intSet = (input.find(',') != std::string::npos) ? stringToIntSet(input) : std::vector<int64_t>();
             }
         }
         
-        m_scan = createScan(pId, dataSize);
-        if (!m_scan.empty())
+        // byte patterns are never compared with previous values, so their blocks only get a search mask
+        m_scan = ScanSession::open(pId, dataSize, m_unaligned, m_regionFilter, m_scanType != SCAN_AOB);
+        if (m_scan)
         {
             break;
         }
@@ -172,27 +549,82 @@ void Scanner::uiNewScan()
     }
 }
 
-// String UI
+/**
+ * \brief Resume a session saved with uiSaveSession. Its process has to be still running.
+ * \return False if the file isn't a valid session or the process is gone
+ */
+bool Scanner::uiLoadSession(const std::string& path)
+{
+    SessionInfo info;
+
+    m_scan = SessionFile::load(path, info);
+    if (!m_scan)
+    {
+        return false;
+    }
+    // the file keeps the filtered regions but not the filter, refreshes pick new regions with the current one
+    m_scan->regionFilter() = m_regionFilter;
+
+    m_scanType = static_cast<ScanType>(info.scanType);
+    m_strEncoding = static_cast<StringEncoding>(info.encoding);
+    m_ignoreCase = info.ignoreCase;
+    m_unaligned = info.unaligned;
+    m_strVal = info.value;
+    m_pattern = AobPattern(info.value);
+    m_intSet.clear();
+    m_resumed = true;
+
+    return true;
+}
 
-void Scanner::uiPrintStringMatches(StringScanner& strScan, int size) 
+void Scanner::uiSaveSession()
 {
-    uintptr_t address;
+    std::string path;
 
-    for (auto& mb : strScan.memblocks())
+    std::cout << "Enter the session file: ";
+    std::getline(std::cin, path);
+    std::cout << "\r\n";
+
+    SessionInfo info {m_scanType, m_strEncoding, m_ignoreCase, m_unaligned, 
+                      m_scanType == SCAN_AOB ? m_pattern.text() : m_strVal};
+    if (SessionFile::save(*m_scan, info, path))
     {
-        for (int offset = 0; offset < mb.size(); offset++) 
-        {
-            if (mb.isInSearch(offset)) 
-            {
-                address = reinterpret_cast<uintptr_t>(mb.addr()) + offset;
-                std::string sVal = strScan.readString(address, size);
-                std::cout << "0x" << std::hex << address << std::dec << " -> value: " << std::flush;
-                std::cout << sVal << std::flush << " | size: " << mb.size() << "\r" << std::endl;
-            }
-        }
+        std::cout << "Session saved to " << path << ", enter <" << path << " as process id to resume it\r\n";
+    }
+    else
+    {
+        std::cout << "Can't write " << path << "\r\n";
     }
 }
 
+/**
+ * \brief Pick up regions mapped since the scan started and drop blocks whose memory is gone
+ */
+void Scanner::uiRefreshRegions()
+{
+    RegionRefresh refresh = m_scan->refreshRegions(m_pool);
+
+    std::cout << refresh.keptBlocks << " blocks kept, " 
+        << refresh.addedRegions << " regions added (" << refresh.addedBytes << " bytes, " 
+        << refresh.addedMatches << " matches), "
+        << refresh.retiredBlocks << " blocks retired (" << refresh.retiredBytes << " bytes, " 
+        << refresh.retiredMatches << " matches lost)\r\n"
+        << getMatchesCount(m_scan->memblocks()) << " matches left";
+}
+
+// String UI
+
+void Scanner::uiPrintStringMatches(StringScanner& strScan, const std::string& value, const std::string& command) 
+{
+    size_t size = strScan.encode(value).size();
+
+    // string scans compare case-insensitively, so there's no point in showing the scanned value
+    uiPrintMatches(strScan.memblocks(), command, size, false, [&](std::string& text, const char* current)
+    {
+        text += strScan.decode(std::string(current, size));
+    });
+}
+
 void Scanner::uiWriteString(StringScanner& scanner)
 {
     uintptr_t addr;
@@ -214,6 +646,8 @@ int Scanner::openStringUi(StringScanner& strScanner)
     std::string input;
     std::string sVal = m_strVal;
 
+    std::cout << "\r\n" << getMatchesCount(strScanner.memblocks()) << " matches found\n";
+
     while (1)
     {
         std::cout << "\r\nEnter the next value or, "
@@ -221,6 +655,7 @@ int Scanner::openStringUi(StringScanner& strScanner)
             "\r\n[d] decreased"
             "\r\n[m] print matches"
             "\r\n[p] poke address"
+            "\r\n[>] save session"
             "\r\n[n] new scan"
             "\r\n[q] quit"
             "\r\n=>";
@@ -240,17 +675,21 @@ int Scanner::openStringUi(StringScanner& strScanner)
                 std::cout << getMatchesCount(strScanner.memblocks()) << " matches found\r\n"; 
                 break;
             case 'm':
-                uiPrintStringMatches(strScanner, sVal.size());
+                uiPrintStringMatches(strScanner, sVal, input);
                 break;
             case 'p':
                 uiWriteString(strScanner);
                 break;
+            case '>':
+                uiSaveSession();
+                break;
             case 'n':
                 return 1;
             case 'q':
                 return 0;
             default:
                 sVal = input.data();
+                m_strVal = sVal;
                 strScanner.updateScan(COND_EQUALS, sVal);
 
                 std::cout << getMatchesCount(strScanner.memblocks()) << " matches left";
@@ -275,7 +714,7 @@ void Scanner::uiWriteInt(IntScanner& scanner)
     std::cout << "\r";
 
     int64_t val = stringToInt(input);
-    switch (scanner.memblocks()[0].dataSize())
+    switch (scanner.dataSize())
     {
         case 1:
             scanner.writeInt8(addr, static_cast<char>(val));
@@ -293,59 +732,145 @@ void Scanner::uiWriteInt(IntScanner& scanner)
     }
 }
 
-void Scanner::uiPrintIntMatches(IntScanner& intScan) 
+/**
+ * \brief Ask for the difference of a COND_INCREASED_BY or COND_DECREASED_BY scan and run it
+ */
+void Scanner::uiUpdateIntBy(IntScanner& scanner, Condition condition)
 {
-    uintptr_t address;
-    char valChar;
-    int16_t valInt16;
-    int32_t valInt32;
-    int64_t valInt64;
+    std::string input;
+
+    std::cout << "Enter the difference: ";
+    std::cin >> input;
+    std::cout << "\r\n";
 
-    for (auto& mb : intScan.memblocks())
+    scanner.updateScan(condition, stringToInt(input));
+    std::cout << getMatchesCount(scanner.memblocks()) << " matches found\r\n";
+}
+
+/**
+ * \brief Ask for mask and value of a COND_BITMASK scan and run it
+ */
+void Scanner::uiUpdateIntBitmask(IntScanner& scanner)
+{
+    std::string input;
+    int64_t mask;
+
+    std::cout << "Enter the mask: ";
+    std::cin >> input;
+    mask = stringToInt(input);
+
+    std::cout << "\nEnter the masked value: ";
+    std::cin >> input;
+    std::cout << "\r\n";
+
+    scanner.updateScan(COND_BITMASK, stringToInt(input), mask);
+    std::cout << getMatchesCount(scanner.memblocks()) << " matches found\r\n";
+}
+
+/**
+ * \brief Search a set of values in one pass and show how often each of them was found
+ */
+void Scanner::uiUpdateIntSet(IntScanner& scanner, const std::vector<int64_t>& values)
+{
+    ValueSet set(values, scanner.dataSize());
+    std::vector<size_t> hits = scanner.updateScanSet(set);
+
+    uiPrintSetHits(set.values(), hits);
+    std::cout << "\r\n" << getMatchesCount(scanner.memblocks()) << " matches found\r\n";
+}
+
+void Scanner::uiPrintSetHits(const std::vector<int64_t>& values, const std::vector<size_t>& hits)
+{
+    for (size_t i = 0; i < hits.size(); i++)
     {
-        for (int offset = 0; offset < mb.size(); offset += mb.dataSize()) 
-        {
-            if (mb.isInSearch(offset)) 
-            {
-                address = reinterpret_cast<uintptr_t>(mb.addr()) + offset;
-                std::cout << "0x" << std::hex << address << std::dec << " -> value: " << std::flush;
-                switch (mb.dataSize())
-                {
-                    case 1:
-                        valChar = intScan.readInt8(address);
-                        std::cout << valChar;
-                        break;
-                    case 2:
-                        valInt16 = intScan.readInt16(address);
-                        std::cout << valInt16;
-                        break;
-                    case 4:
-                        valInt32 = intScan.readInt32(address);
-                        std::cout << valInt32;
-                        break;
-                    case 8:
-                        valInt64 = intScan.readInt64(address);
-                        std::cout << valInt64;
-                        break;
-                }
-                std::cout << std::flush << " | size: " << mb.size() << "\r" << std::endl;
-            }
-        }
+        std::cout << "\r\n" << values[i] << ": " << hits[i] << " matches";
     }
 }
 
+/**
+ * \brief Ask for a target address and search limits, then write every pointer path to the target into a file
+ */
+void Scanner::uiFindPointerPaths()
+{
+    std::string input;
+    uintptr_t target;
+    int maxDepth = 4;
+    size_t maxOffset = 0x1000;
+
+    std::cout << "Enter the target address: ";
+    std::getline(std::cin, input);
+    target = stringToInt(input);
+
+    std::cout << "\nEnter the max depth (empty for " << maxDepth << "): ";
+    std::getline(std::cin, input);
+    if (!input.empty())
+    {
+        maxDepth = stringToInt(input);
+    }
+
+    std::cout << "\nEnter the max offset (empty for 0x" << std::hex << maxOffset << std::dec << "): ";
+    std::getline(std::cin, input);
+    if (!input.empty())
+    {
+        maxOffset = stringToInt(input);
+    }
+
+    std::cout << "\nEnter the output file: ";
+    std::getline(std::cin, input);
+    std::cout << "\r\n";
+
+    std::ofstream out(input);
+    if (!out)
+    {
+        std::cout << "Can't open " << input << "\r\n";
+        return;
+    }
+
+    PointerScanner pointerScanner(m_scan, m_pool);
+    std::cout << pointerScanner.pointerMap().size() << " pointers mapped\r\n";
+    std::cout << pointerScanner.scan(target, maxDepth, maxOffset, out) << " pointer paths written to " << input 
+        << "\r\n";
+}
+
+void Scanner::uiPrintIntMatches(IntScanner& intScan, const std::string& command) 
+{
+    int dataSize = intScan.dataSize();
+
+    uiPrintMatches(intScan.memblocks(), command, dataSize, true, [&](std::string& text, const char* value)
+    {
+        text += std::to_string(MemBlock::toInt(value, dataSize));
+    });
+}
+
 int Scanner::openIntUi(IntScanner& intScanner)
 {
     std::string input;
     int64_t iVal = m_intVal;
+    int64_t iVal2 = m_intVal2;
+    Condition condition;
+
+    uiPrintSetHits(m_intSet, m_setHits);
+    m_setHits.clear();
+    std::cout << "\r\n" << getMatchesCount(intScanner.memblocks()) << " matches found\n";
 
     while (1)
     {
-        std::cout << "\r\nEnter the next value or, "
+        std::cout << "\r\nEnter the next value (lo..hi for a range, a,b,c for a set) or, "
             "\r\n[i] increased"
             "\r\n[d] decreased"
+            "\r\n[c] changed"
+            "\r\n[u] unchanged"
+            "\r\n[+] increased by"
+            "\r\n[-] decreased by"
+            "\r\n[&] bitmask"
+            "\r\n[t] find pointer paths"
+            "\r\n[f] freeze address"
+            "\r\n[x] unfreeze address"
+            "\r\n[w] watch addresses"
+            "\r\n[e] re-enumerate regions"
             "\r\n[m] print matches"
             "\r\n[p] poke address"
+            "\r\n[>] save session"
             "\r\n[n] new scan"
             "\r\n[q] quit"
             "\r\n=>";
@@ -364,22 +889,275 @@ int Scanner::openIntUi(IntScanner& intScanner)
                 intScanner.updateScan(COND_DECREASED, iVal);
                 std::cout << getMatchesCount(intScanner.memblocks()) << " matches found\r\n"; 
                 break;
-            case 'p':
-                uiPrintIntMatches(intScanner);
+            case 'c':
+                intScanner.updateScan(COND_CHANGED, iVal);
+                std::cout << getMatchesCount(intScanner.memblocks()) << " matches found\r\n"; 
+                break;
+            case 'u':
+                intScanner.updateScan(COND_UNCHANGED, iVal);
+                std::cout << getMatchesCount(intScanner.memblocks()) << " matches found\r\n"; 
+                break;
+            case '+':
+                uiUpdateIntBy(intScanner, COND_INCREASED_BY);
+                break;
+            case '&':
+                uiUpdateIntBitmask(intScanner);
+                break;
+            case 't':
+                uiFindPointerPaths();
+                break;
+            case 'f':
+                uiFreeze(false);
+                break;
+            case 'x':
+                uiUnfreeze();
+                break;
+            case 'w':
+                uiWatch(false);
+                break;
+            case 'e':
+                uiRefreshRegions();
                 break;
             case 'm':
+                uiPrintIntMatches(intScanner, input);
+                break;
+            case 'p':
                 uiWriteInt(intScanner);
                 break;
+            case '>':
+                uiSaveSession();
+                break;
             case 'n':
                 return 1;
             case 'q':
                 return 0;
+            case '-':
+                // a lone '-', negative values are handled below
+                if (input.size() == 1)
+                {
+                    uiUpdateIntBy(intScanner, COND_DECREASED_BY);
+                    break;
+                }
+                [[fallthrough]];
             default:
-                iVal = stringToInt(input);
-                intScanner.updateScan(COND_EQUALS, iVal);
+                if (input.find(',') != std::string::npos)
+                {
+                    uiUpdateIntSet(intScanner, stringToIntSet(input));
+                    break;
+                }
+                condition = stringToIntCondition(input, iVal, iVal2);
+                intScanner.updateScan(condition, iVal, iVal2);
 
                 std::cout << getMatchesCount(intScanner.memblocks()) << " matches left";
                 break;
         }
     }
+}
+
+// Float UI
+
+void Scanner::uiWriteFloat(FloatScanner& scanner)
+{
+    uintptr_t addr;
+    std::string input;
+
+    std::cout << "Enter the address: ";
+    std::cin >> input;
+    addr = stringToInt(input);
+
+    std::cout << "\nEnter the value: ";
+    std::cin >> input;
+    std::cout << "\r";
+
+    double val = std::strtod(input.c_str(), nullptr);
+    if (scanner.dataSize() == 8)
+    {
+        scanner.writeDouble(addr, val);
+    }
+    else
+    {
+        scanner.writeFloat(addr, static_cast<float>(val));
+    }
+}
+
+void Scanner::uiPrintFloatMatches(FloatScanner& floatScan, const std::string& command) 
+{
+    int dataSize = floatScan.dataSize();
+
+    uiPrintMatches(floatScan.memblocks(), command, dataSize, true, [&](std::string& text, const char* value)
+    {
+        char number[32];
+        double val;
+
+        if (dataSize == 8)
+        {
+            std::memcpy(&val, value, sizeof(val));
+        }
+        else
+        {
+            float fVal;
+            std::memcpy(&fVal, value, sizeof(fVal));
+            val = fVal;
+        }
+        std::snprintf(number, sizeof(number), "%g", val);
+        text += number;
+    });
+}
+
+int Scanner::openFloatUi(FloatScanner& floatScanner)
+{
+    std::string input;
+    FloatRange range = m_floatRange;
+
+    std::cout << "\r\n" << getMatchesCount(floatScanner.memblocks()) << " matches found\n";
+
+    while (1)
+    {
+        std::cout << "\r\nEnter the next value (lo..hi for a range) or, "
+            "\r\n[i] increased"
+            "\r\n[d] decreased"
+            "\r\n[c] changed"
+            "\r\n[u] unchanged"
+            "\r\n[f] freeze address"
+            "\r\n[x] unfreeze address"
+            "\r\n[w] watch addresses"
+            "\r\n[e] re-enumerate regions"
+            "\r\n[m] print matches"
+            "\r\n[p] poke address"
+            "\r\n[>] save session"
+            "\r\n[n] new scan"
+            "\r\n[q] quit"
+            "\r\n=>";
+
+        std::cin >> input;
+        std::cin.ignore(1024, '\n');
+        std::cout << "\r\n";
+
+        switch (input[0])
+        {
+            case 'i':         
+                floatScanner.updateScan(COND_INCREASED, range);
+                std::cout << getMatchesCount(floatScanner.memblocks()) << " matches found\r\n";
+                break;
+            case 'd':
+                floatScanner.updateScan(COND_DECREASED, range);
+                std::cout << getMatchesCount(floatScanner.memblocks()) << " matches found\r\n"; 
+                break;
+            case 'c':
+                floatScanner.updateScan(COND_CHANGED, range);
+                std::cout << getMatchesCount(floatScanner.memblocks()) << " matches found\r\n"; 
+                break;
+            case 'u':
+                floatScanner.updateScan(COND_UNCHANGED, range);
+                std::cout << getMatchesCount(floatScanner.memblocks()) << " matches found\r\n"; 
+                break;
+            case 'f':
+                uiFreeze(true);
+                break;
+            case 'x':
+                uiUnfreeze();
+                break;
+            case 'w':
+                uiWatch(true);
+                break;
+            case 'e':
+                uiRefreshRegions();
+                break;
+            case 'm':
+                uiPrintFloatMatches(floatScanner, input);
+                break;
+            case 'p':
+                uiWriteFloat(floatScanner);
+                break;
+            case '>':
+                uiSaveSession();
+                break;
+            case 'n':
+                return 1;
+            case 'q':
+                return 0;
+            default:
+                range = FloatRange::parse(input, floatScanner.dataSize());
+                floatScanner.updateScan(COND_EQUALS, range);
+
+                std::cout << getMatchesCount(floatScanner.memblocks()) << " matches left";
+                break;
+        }
+    }
+}
+
+// AOB UI
+
+void Scanner::uiPrintAobMatches(AobScanner& aobScan, const std::string& command)
+{
+    size_t size = m_pattern.bytes().size();
+
+    uiPrintMatches(aobScan.memblocks(), command, size, false, [&](std::string& text, const char* value)
+    {
+        char byte[4];
+
+        for (size_t i = 0; i < size; i++)
+        {
+            std::snprintf(byte, sizeof(byte), i == 0 ? "%02x" : " %02x", static_cast<unsigned char>(value[i]));
+            text += byte;
+        }
+    });
+}
+
+int Scanner::openAobUi(AobScanner& aobScanner)
+{
+    std::string input;
+
+    std::cout << "\r\n" << getMatchesCount(aobScanner.memblocks()) << " matches found\n";
+
+    while (1)
+    {
+        std::cout << "\r\nEnter the next pattern or, "
+            "\r\n[r] rescan with the same pattern"
+            "\r\n[m] print matches"
+            "\r\n[>] save session"
+            "\r\n[n] new scan"
+            "\r\n[q] quit"
+            "\r\n=>";
+
+        // patterns contain spaces
+        std::getline(std::cin, input);
+        std::cout << "\r\n";
+        if (input.empty())
+        {
+            continue;
+        }
+
+        switch (input[0])
+        {
+            case 'r':
+                aobScanner.updateScan(m_pattern);
+                std::cout << getMatchesCount(aobScanner.memblocks()) << " matches found\r\n";
+                break;
+            case 'm':
+                uiPrintAobMatches(aobScanner, input);
+                break;
+            case '>':
+                uiSaveSession();
+                break;
+            case 'n':
+                return 1;
+            case 'q':
+                return 0;
+            default:
+            {
+                AobPattern pattern(input);
+                if (!pattern.isValid())
+                {
+                    std::cout << "Invalid pattern";
+                    break;
+                }
+                m_pattern = pattern;
+                aobScanner.updateScan(m_pattern);
+
+                std::cout << getMatchesCount(aobScanner.memblocks()) << " matches left";
+                break;
+            }
+        }
+    }
 }
\ No newline at end of file
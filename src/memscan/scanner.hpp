@@ -1,38 +1,108 @@
 #pragma once
+#include "aobscanner.hpp"
+#include "floatscanner.hpp"
+#include "freezer.hpp"
 #include "intscanner.hpp"
 #include "memblock.hpp"
+#include "regionfilter.hpp"
+#include "scansession.hpp"
 #include "stringscanner.hpp"
+#include "threadpool.hpp"
+#include "watchlist.hpp"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+
+enum ScanType
+{
+    SCAN_INT,
+    SCAN_FLOAT,
+    SCAN_STRING,
+    SCAN_AOB
+};
 
 /**
  * \brief Implements user interface for string/integer scanners + initializes process memory for reading/writing
+ * \param threadCount Number of scan threads, 0 uses all hardware threads
+ * \param freezeInterval Time between two rewrites of the frozen values
+ * \param maxMatches Matches printed per page, 0 prints all of them
+ * \param regionFilter Regions new scans are limited to
  */
 class Scanner
 {
     public:
+        Scanner(int threadCount, std::chrono::microseconds freezeInterval, size_t maxMatches, 
+                const RegionFilter& regionFilter);
+
         void uiNewScan();
 
         StringScanner createStringScanner(Condition startCondition);
         IntScanner createIntScanner(Condition startCondition);
+        FloatScanner createFloatScanner(Condition startCondition);
+        AobScanner createAobScanner();
 
         int openStringUi(StringScanner& stringScanner);
         int openIntUi(IntScanner& intScanner);
+        int openFloatUi(FloatScanner& floatScanner);
+        int openAobUi(AobScanner& aobScanner);
 
-        const bool&      isString()       const { return m_isString; }
+        const ScanType&  scanType()       const { return m_scanType; }
         const Condition& startCondition() const { return m_startCondition; }
 
     private:
-        std::vector<MemBlock> m_scan;
+        typedef std::function<void(std::string& text, const char* value)> ValueFormatter;
+
+        ThreadPool m_pool;
+        std::shared_ptr<ScanSession> m_scan;
+        std::unique_ptr<Freezer> m_freezer;
+        std::chrono::microseconds m_freezeInterval;
+        size_t m_maxMatches;
+        RegionFilter m_regionFilter;
+        size_t m_printFirst;
+        size_t m_printTotal;
         Condition m_startCondition;
         int64_t m_intVal;
+        int64_t m_intVal2;
+        std::vector<int64_t> m_intSet;
+        // matches per value of m_intSet found by the first scan
+        std::vector<size_t> m_setHits;
+        FloatRange m_floatRange;
         std::string m_strVal;
-        bool m_isString;
+        StringEncoding m_strEncoding;
+        bool m_ignoreCase;
+        AobPattern m_pattern;
+        ScanType m_scanType;
+        bool m_unaligned;
+        // the session was loaded from a file and already holds the results of its scans
+        bool m_resumed;
             
-        std::vector<MemBlock> createScan(int processId, int dataSize);
-        int getMatchesCount(std::vector<MemBlock>& mbScan);
+        Freezer& freezer();
+        size_t getMatchesCount(std::vector<MemBlock>& mbScan);
+        std::vector<uintptr_t> matchAddresses(size_t limit);
         long long stringToInt(std::string s);
+        Condition stringToIntCondition(std::string s, int64_t& val, int64_t& val2);
+        std::vector<int64_t> stringToIntSet(const std::string& s);
 
-        void uiPrintStringMatches(StringScanner& strScanner, int size);
+        void uiPrintMatches(std::vector<MemBlock>& memblocks, const std::string& command, size_t valueSize,
+                            bool hasSnapshot, const ValueFormatter& format);
+        void uiPrintStringMatches(StringScanner& strScanner, const std::string& value, const std::string& command);
         void uiWriteString(StringScanner& strScanner);
-        void uiPrintIntMatches(IntScanner& intScanner);
+        void uiPrintIntMatches(IntScanner& intScanner, const std::string& command);
         void uiWriteInt(IntScanner& intScanner);
+        void uiUpdateIntBy(IntScanner& intScanner, Condition condition);
+        void uiUpdateIntBitmask(IntScanner& intScanner);
+        void uiUpdateIntSet(IntScanner& intScanner, const std::vector<int64_t>& values);
+        void uiPrintSetHits(const std::vector<int64_t>& values, const std::vector<size_t>& hits);
+        void uiFindPointerPaths();
+        bool uiLoadSession(const std::string& path);
+        void uiSaveSession();
+        void uiRefreshRegions();
+        void uiFreeze(bool isFloat);
+        void uiUnfreeze();
+        void uiWatch(bool isFloat);
+        void uiPrintFloatMatches(FloatScanner& floatScanner, const std::string& command);
+        void uiWriteFloat(FloatScanner& floatScanner);
+        void uiPrintAobMatches(AobScanner& aobScanner, const std::string& command);
 };
\ No newline at end of file
@@ -0,0 +1,386 @@
+#include "intscanner.hpp"
+#include "matchpage.hpp"
+#include "scanplan.hpp"
+#include "valueset.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+    /**
+     * \brief Command as a quoted JSON or CSV string
+     */
+    std::string quote(const std::string& s, PlanFormat format)
+    {
+        std::string quoted = "\"";
+
+        for (char c : s)
+        {
+            if (c == '"')
+            {
+                quoted += format == FORMAT_CSV ? "\"\"" : "\\\"";
+            }
+            else if (c == '\\' && format == FORMAT_NDJSON)
+            {
+                quoted += "\\\\";
+            }
+            else if (static_cast<unsigned char>(c) >= 0x20)
+            {
+                quoted += c;
+            }
+        }
+
+        return quoted + "\"";
+    }
+}
+
+ScanPlan::ScanPlan(int dataSize, bool isFloat)
+    : m_dataSize(dataSize)
+    , m_isFloat(isFloat)
+{}
+
+/**
+ * \brief Parse a plan. Nothing of it runs if a line is invalid.
+ * \param error Line number and reason if the plan is invalid
+ * \return False if the plan is invalid
+ */
+bool ScanPlan::load(std::istream& in, std::string& error)
+{
+    std::string text;
+    bool hasPass = false;
+
+    m_steps.clear();
+    for (size_t line = 1; std::getline(in, text); line++)
+    {
+        std::string word;
+        std::string value;
+        PlanStep step {};
+
+        // Windows line endings
+        if (!text.empty() && text.back() == '\r')
+        {
+            text.pop_back();
+        }
+
+        std::istringstream words(text);
+        if (!(words >> word) || word[0] == '#')
+        {
+            continue;
+        }
+        words >> value;
+
+        step.command = text;
+        step.line = line;
+        if (word == "scan" || word == "filter")
+        {
+            step.action = word == "scan" ? PLAN_SCAN : PLAN_FILTER;
+            if (step.action == PLAN_SCAN && hasPass)
+            {
+                error = "line " + std::to_string(line) + ": scan has to be the first pass";
+                return false;
+            }
+            if (!parseValue(value, step.action == PLAN_SCAN, step))
+            {
+                error = "line " + std::to_string(line) + ": invalid value '" + value + "'";
+                return false;
+            }
+            hasPass = true;
+        }
+        else if (word == "sleep" || word == "print")
+        {
+            char* end = nullptr;
+
+            step.action = word == "sleep" ? PLAN_SLEEP : PLAN_PRINT;
+            step.count = std::strtoull(value.c_str(), &end, 10);
+            if (*end != '\0' || (step.action == PLAN_SLEEP && value.empty()))
+            {
+                error = "line " + std::to_string(line) + ": invalid number '" + value + "'";
+                return false;
+            }
+        }
+        else if (word == "wait" || word == "refresh")
+        {
+            step.action = word == "wait" ? PLAN_WAIT : PLAN_REFRESH;
+        }
+        else
+        {
+            error = "line " + std::to_string(line) + ": unknown command '" + word + "'";
+            return false;
+        }
+
+        m_steps.push_back(step);
+    }
+
+    return true;
+}
+
+/**
+ * \brief Parse the value of a pass. A scan has no previous pass to compare with, so it takes a value or nothing, a
+ * filter takes a value or a condition.
+ * \param isScan The step is a scan
+ */
+bool ScanPlan::parseValue(const std::string& s, bool isScan, PlanStep& step) const
+{
+    bool isRelative = s == "i" || s == "d" || s == "c" || s == "u";
+
+    if (s.empty())
+    {
+        step.condition = COND_UNCONDITIONAL;
+        return isScan;
+    }
+    if (isRelative)
+    {
+        step.condition = s == "i" ? COND_INCREASED : s == "d" ? COND_DECREASED : s == "c" ? COND_CHANGED 
+                                                                                       : COND_UNCHANGED;
+        return !isScan;
+    }
+
+    if (m_isFloat)
+    {
+        const char* begin = s.c_str() + (s[0] == '=' ? 1 : 0);
+        char* end = nullptr;
+
+        std::strtod(begin, &end);
+        step.condition = COND_EQUALS;
+        step.range = FloatRange::parse(s, m_dataSize);
+        return end != begin;
+    }
+
+    if (s.find(',') != std::string::npos)
+    {
+        size_t begin = 0;
+
+        while (begin <= s.size())
+        {
+            size_t comma = std::min(s.find(',', begin), s.size());
+            std::string number = s.substr(begin, comma - begin);
+            char* end = nullptr;
+
+            step.set.push_back(std::strtoll(number.c_str(), &end, 0));
+            if (number.empty() || *end != '\0')
+            {
+                return false;
+            }
+            begin = comma + 1;
+        }
+        return true;
+    }
+
+    return parseIntCondition(s, step.condition, step.args) &&
+           !(isScan && (step.condition == COND_INCREASED_BY || step.condition == COND_DECREASED_BY));
+}
+
+/**
+ * \brief Parse an integer condition: "i", "d", "c" and "u" for increased, decreased, changed and unchanged, "v" or 
+ * "=v" for equals, "+v" and "-v" for increased and decreased by v, "lo..hi" for between. Negative values are only
+ * equal to with "=", e.g. "=-5".
+ * \return False if s isn't a condition
+ */
+bool ScanPlan::parseIntCondition(const std::string& s, Condition& condition, Kernels::FilterArgs& args)
+{
+    if (s.empty())
+    {
+        return false;
+    }
+
+    size_t dots = s.find("..");
+    char* end = nullptr;
+
+    if (s == "i" || s == "d" || s == "c" || s == "u")
+    {
+        condition = s == "i" ? COND_INCREASED : s == "d" ? COND_DECREASED : s == "c" ? COND_CHANGED : COND_UNCHANGED;
+        return true;
+    }
+    if (dots != std::string::npos)
+    {
+        char* end2 = nullptr;
+        std::string low = s.substr(0, dots);
+        std::string high = s.substr(dots + 2);
+
+        condition = COND_BETWEEN;
+        args.val = std::strtoll(low.c_str(), &end, 0);
+        args.val2 = std::strtoll(high.c_str(), &end2, 0);
+        return !low.empty() && !high.empty() && *end == '\0' && *end2 == '\0';
+    }
+    if (s[0] == '=' || s[0] == '+' || s[0] == '-')
+    {
+        condition = s[0] == '=' ? COND_EQUALS : s[0] == '+' ? COND_INCREASED_BY : COND_DECREASED_BY;
+        args.val = std::strtoll(s.c_str() + 1, &end, 0);
+        return s.size() > 1 && *end == '\0';
+    }
+
+    condition = COND_EQUALS;
+    args.val = std::strtoll(s.c_str(), &end, 0);
+    return *end == '\0';
+}
+
+/**
+ * \brief Run all steps on session. A plan whose first pass is a filter gets an unconditional scan first, written
+ * as step 0.
+ */
+void ScanPlan::run(std::shared_ptr<ScanSession> session, ThreadPool& pool, PlanFormat format, 
+                   std::ostream& out) const
+{
+    bool scanned = false;
+
+    if (format == FORMAT_CSV)
+    {
+        out << "step,line,command,matches,seconds,addr,value,previous\n";
+    }
+
+    for (size_t i = 0; i < m_steps.size(); i++)
+    {
+        const PlanStep& step = m_steps[i];
+
+        switch (step.action)
+        {
+            case PLAN_SCAN:
+            case PLAN_FILTER:
+            {
+                if (!scanned && step.action == PLAN_FILTER)
+                {
+                    PlanStep scan {};
+                    scan.action = PLAN_SCAN;
+                    scan.command = "scan";
+                    scan.condition = COND_UNCONDITIONAL;
+
+                    auto start = std::chrono::steady_clock::now();
+                    runPass(scan, session, pool);
+                    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                    writePass(scan, 0, session->matches(), elapsed.count(), format, out);
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                runPass(step, session, pool);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                writePass(step, i + 1, session->matches(), elapsed.count(), format, out);
+                scanned = true;
+                break;
+            }
+            case PLAN_SLEEP:
+                out.flush();
+                std::this_thread::sleep_for(std::chrono::milliseconds(step.count));
+                break;
+            case PLAN_WAIT:
+            {
+                std::string line;
+                out.flush();
+                std::getline(std::cin, line);
+                break;
+            }
+            case PLAN_PRINT:
+                writeMatches(step, i + 1, *session, format, out);
+                break;
+            case PLAN_REFRESH:
+            {
+                auto start = std::chrono::steady_clock::now();
+                session->refreshRegions(pool);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                writePass(step, i + 1, session->matches(), elapsed.count(), format, out);
+                break;
+            }
+        }
+    }
+    out.flush();
+}
+
+void ScanPlan::runPass(const PlanStep& step, std::shared_ptr<ScanSession> session, ThreadPool& pool) const
+{
+    if (m_isFloat)
+    {
+        FloatScanner(session, pool).updateScan(step.condition, step.range);
+    }
+    else if (!step.set.empty())
+    {
+        IntScanner(session, pool).updateScanSet(ValueSet(step.set, m_dataSize));
+    }
+    else
+    {
+        IntScanner(session, pool).updateScan(step.condition, step.args.val, step.args.val2);
+    }
+}
+
+void ScanPlan::writePass(const PlanStep& step, size_t index, size_t matches, double seconds, PlanFormat format,
+                         std::ostream& out) const
+{
+    char numbers[96];
+
+    if (format == FORMAT_CSV)
+    {
+        std::snprintf(numbers, sizeof(numbers), ",%zu,%.6f,,,\n", matches, seconds);
+        out << index << "," << step.line << "," << quote(step.command, format) << numbers;
+        return;
+    }
+
+    std::snprintf(numbers, sizeof(numbers), ",\"matches\":%zu,\"seconds\":%.6f}\n", matches, seconds);
+    out << "{\"step\":" << index << ",\"line\":" << step.line << ",\"command\":" << quote(step.command, format) 
+        << numbers;
+}
+
+/**
+ * \brief Write the first step.count matches with one batched read of their current values
+ */
+void ScanPlan::writeMatches(const PlanStep& step, size_t index, const ScanSession& session, PlanFormat format,
+                            std::ostream& out) const
+{
+    MatchPage page(session.pHandle(), session.memblocks(), 0, step.count, m_dataSize, true);
+    std::string prefix;
+    std::string text;
+    char addr[32];
+
+    if (format == FORMAT_CSV)
+    {
+        prefix = std::to_string(index) + "," + std::to_string(step.line) + "," + quote(step.command, format) + ",,,";
+    }
+    else
+    {
+        prefix = "{\"step\":" + std::to_string(index) + ",\"line\":" + std::to_string(step.line) + ",\"addr\":";
+    }
+
+    for (auto& entry : page.entries())
+    {
+        std::snprintf(addr, sizeof(addr), "0x%llx", static_cast<unsigned long long>(entry.addr));
+        std::string value = entry.current ? formatValue(entry.current) : "";
+        std::string previous = formatValue(entry.snapshot);
+
+        if (format == FORMAT_CSV)
+        {
+            text += prefix + addr + "," + value + "," + previous + "\n";
+        }
+        else
+        {
+            text += prefix + "\"" + addr + "\",\"value\":" + (value.empty() ? "null" : value) + 
+                    ",\"previous\":" + (previous.empty() ? "null" : previous) + "}\n";
+        }
+    }
+
+    out.write(text.data(), text.size());
+}
+
+/**
+ * \brief Value as a JSON/CSV number, or empty if it has none (NaN, infinity)
+ */
+std::string ScanPlan::formatValue(const char* value) const
+{
+    int64_t bits = MemBlock::toInt(value, m_dataSize);
+    char number[32];
+
+    if (!m_isFloat)
+    {
+        return std::to_string(bits);
+    }
+
+    double val = FloatScanner::toDouble(bits, m_dataSize);
+    if (!std::isfinite(val))
+    {
+        return "";
+    }
+    std::snprintf(number, sizeof(number), "%.*g", m_dataSize == 4 ? 9 : 17, val);
+    return number;
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+#include "floatscanner.hpp"
+#include "kernels.hpp"
+#include "memblock.hpp"
+#include "scansession.hpp"
+#include "threadpool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum PlanAction
+{
+    PLAN_SCAN,
+    PLAN_FILTER,
+    PLAN_SLEEP,
+    PLAN_WAIT,
+    PLAN_PRINT,
+    PLAN_REFRESH
+};
+
+enum PlanFormat
+{
+    FORMAT_NDJSON,
+    FORMAT_CSV
+};
+
+/**
+ * \brief Line of a ScanPlan, parsed up front so that running the plan never stops at a typo
+ */
+struct PlanStep
+{
+    PlanAction action;
+    std::string command;
+    size_t line;
+    Condition condition;
+    Kernels::FilterArgs args;
+    FloatRange range;
+    std::vector<int64_t> set;
+    // milliseconds of PLAN_SLEEP, match limit of PLAN_PRINT
+    size_t count;
+};
+
+/**
+ * \brief Scan driven by a script instead of the console, one command per line:
+ * - scan [value]: first pass, all values if no value is given
+ * - filter condition: next pass, a value or i, d, c, u (+v, -v for integers)
+ * - sleep ms: pause between passes
+ * - wait: pause until a line arrives on stdin, for harnesses that change the target in between
+ * - print [n]: write the first n matches (all by default) with their current values
+ * - refresh: add the regions mapped since the scan and drop the blocks whose memory is gone, written like a pass
+ *
+ * Empty lines and lines starting with # are skipped. A plan whose first pass is a filter starts with an unconditional
+ * scan. Every pass and every printed match is written as one NDJSON object or CSV row, nothing else goes to out.
+ * \param dataSize Size of the values in bytes
+ * \param isFloat Values are float/double instead of integers
+ */
+class ScanPlan
+{
+    public:
+        ScanPlan(int dataSize, bool isFloat);
+
+        bool load(std::istream& in, std::string& error);
+        void run(std::shared_ptr<ScanSession> session, ThreadPool& pool, PlanFormat format, std::ostream& out) const;
+
+        static bool parseIntCondition(const std::string& s, Condition& condition, Kernels::FilterArgs& args);
+
+        const std::vector<PlanStep>& steps() const { return m_steps; }
+
+    private:
+        int m_dataSize;
+        bool m_isFloat;
+        std::vector<PlanStep> m_steps;
+
+        bool parseValue(const std::string& s, bool isScan, PlanStep& step) const;
+        void runPass(const PlanStep& step, std::shared_ptr<ScanSession> session, ThreadPool& pool) const;
+        void writePass(const PlanStep& step, size_t index, size_t matches, double seconds, PlanFormat format, 
+                       std::ostream& out) const;
+        void writeMatches(const PlanStep& step, size_t index, const ScanSession& session, PlanFormat format,
+                          std::ostream& out) const;
+        std::string formatValue(const char* value) const;
+};
\ No newline at end of file
@@ -0,0 +1,355 @@
+#include "blockreader.hpp"
+#include "scansession.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace
+{
+    uintptr_t regionEnd(const Region& region)
+    {
+        return reinterpret_cast<uintptr_t>(region.addr) + region.size;
+    }
+
+    /**
+     * \brief Sort by address, the pieces of several include ranges of a filter come in the order of the ranges
+     */
+    void sortRegions(std::vector<Region>& regions)
+    {
+        std::sort(regions.begin(), regions.end(), [](const Region& a, const Region& b) { return a.addr < b.addr; });
+    }
+
+    /**
+     * \brief Region of the sorted table that starts at addr, or nullptr
+     */
+    const Region* findRegion(const std::vector<Region>& regions, const char* addr)
+    {
+        auto it = std::lower_bound(regions.begin(), regions.end(), addr, [](const Region& region, const char* addr)
+        {
+            return region.addr < addr;
+        });
+
+        return it != regions.end() && it->addr == addr ? &*it : nullptr;
+    }
+
+    /**
+     * \brief Check if current is still the mapping previous was. Only the heap grows in place (brk), any other change
+     * of size means the range was unmapped and mapped again. A range that was remapped with the same start, size, kind
+     * and path can't be told apart.
+     */
+    bool isSameMapping(const Region& previous, const Region& current)
+    {
+        return previous.kind == current.kind && previous.path == current.path &&
+               (current.size == previous.size || (current.kind == REGION_HEAP && current.size > previous.size));
+    }
+
+    /**
+     * \brief Check if [begin, end) lies within a single region of the sorted table
+     */
+    bool isCovered(const std::vector<Region>& regions, uintptr_t begin, uintptr_t end)
+    {
+        auto next = std::upper_bound(regions.begin(), regions.end(), begin, [](uintptr_t addr, const Region& region)
+        {
+            return addr < reinterpret_cast<uintptr_t>(region.addr);
+        });
+
+        return next != regions.begin() && end <= regionEnd(*(next - 1));
+    }
+}
+
+ScanSession::ScanSession(ProcessHandle pHandle, int processId, int dataSize)
+    : m_pHandle(pHandle)
+    , m_processId(processId)
+    , m_dataSize(dataSize)
+    , m_unaligned(false)
+    , m_hasSnapshot(true)
+    , m_isScanned(false)
+{}
+
+ScanSession::~ScanSession()
+{
+    Process::close(m_pHandle);
+}
+
+/**
+ * \brief Number of matches left in all blocks
+ */
+size_t ScanSession::matches() const
+{
+    size_t matches = 0;
+
+    for (auto& mb : m_memblocks)
+    {
+        matches += mb.matches();
+    }
+
+    return matches;
+}
+
+/**
+ * \brief Open the process and create a MemBlock for each of its writable regions that passes filter
+ * \param hasSnapshot Blocks keep a copy of their region. Byte pattern scans don't need one.
+ * \return Session, or nullptr if the process can't be opened or has no writable memory
+ */
+std::shared_ptr<ScanSession> ScanSession::open(int processId, int dataSize, bool unaligned, const RegionFilter& filter,
+                                               bool hasSnapshot)
+{
+    ProcessHandle pHandle = Process::open(processId);
+
+    if (!Process::isValid(pHandle)) 
+    {
+        return nullptr;
+    }
+
+    // the session owns the handle from here on and closes it when dropped
+    auto session = std::make_shared<ScanSession>(pHandle, processId, dataSize);
+    std::vector<Region> regions = Process::writableRegions(pHandle);
+
+    // before the blocks are created, filtered regions never get a buffer
+    filter.apply(regions);
+    sortRegions(regions);
+    session->regionFilter() = filter;
+    session->regions() = regions;
+    session->unaligned() = unaligned;
+    session->hasSnapshot() = hasSnapshot;
+    for (auto& region : regions)
+    {
+        session->memblocks().emplace_back(pHandle, region, dataSize, unaligned, hasSnapshot);
+    }
+    if (session->memblocks().empty())
+    {
+        return nullptr;
+    }
+
+    return session;
+}
+
+/**
+ * \brief Diff the current writable regions of the process against the region table of the session.
+ *
+ * Regions of the table that are still mapped with the same start, size, kind and path keep their blocks as they are,
+ * with their buffers and matches, a heap that grew only adds its new tail. Blocks of any other region are retired,
+ * even if a new mapping covers their range, because its content has nothing to do with the values of the last scan.
+ * Regions that weren't in the table are read into new blocks with every readable value as a match, as an
+ * unconditional scan would leave them, so the next filter narrows them down along with the rest. The region filter
+ * of the session applies to the new regions as well.
+ * \param pool Threads reading the new regions
+ */
+RegionRefresh ScanSession::refreshRegions(ThreadPool& pool)
+{
+    RegionRefresh refresh = {};
+    std::vector<Region> current = Process::writableRegions(m_pHandle);
+    std::vector<Region> kept;
+    std::vector<Region> added;
+    std::vector<MemBlock> memblocks;
+
+    m_regionFilter.apply(current);
+    sortRegions(current);
+    for (auto& region : current)
+    {
+        const Region* previous = findRegion(m_regions, region.addr);
+
+        if (!previous || !isSameMapping(*previous, region))
+        {
+            added.push_back(region);
+            continue;
+        }
+        kept.push_back(*previous);
+        if (region.size > previous->size)
+        {
+            added.push_back({region.addr + previous->size, region.size - previous->size, region.kind, region.path});
+        }
+    }
+
+    for (auto& mb : m_memblocks)
+    {
+        uintptr_t begin = reinterpret_cast<uintptr_t>(mb.addr());
+
+        if (isCovered(kept, begin, begin + mb.size()))
+        {
+            memblocks.push_back(std::move(mb));
+            refresh.keptBlocks++;
+            continue;
+        }
+        refresh.retiredBlocks++;
+        refresh.retiredBytes += mb.size();
+        refresh.retiredMatches += mb.matches();
+    }
+
+    for (auto& region : added)
+    {
+        refresh.addedRegions++;
+        refresh.addedBytes += region.size;
+    }
+    for (auto& mb : readAdded(added, pool))
+    {
+        refresh.addedMatches += mb.matches();
+        memblocks.push_back(std::move(mb));
+    }
+
+    std::sort(memblocks.begin(), memblocks.end(), [](const MemBlock& a, const MemBlock& b)
+    {
+        return a.addr() < b.addr();
+    });
+    m_memblocks.swap(memblocks);
+    m_regions.swap(current);
+
+    return refresh;
+}
+
+/**
+ * \brief Create a block for every added region and read it in parallel. Unreadable pages leave the search, blocks
+ * without anything readable are dropped.
+ */
+std::vector<MemBlock> ScanSession::readAdded(const std::vector<Region>& added, ThreadPool& pool)
+{
+    std::vector<MemBlock> memblocks;
+
+    for (auto& region : added)
+    {
+        memblocks.emplace_back(m_pHandle, region, m_dataSize, m_unaligned, m_hasSnapshot);
+        memblocks.back().matches() = 0;
+    }
+    if (memblocks.empty())
+    {
+        return memblocks;
+    }
+
+    {
+        BlockReader reader(m_pHandle, memblocks, m_unaligned ? m_dataSize - 1 : 0);
+
+        while (reader.next())
+        {
+            std::vector<ScanChunk> chunks = reader.chunks();
+            std::vector<std::vector<size_t>> workerMatches(pool.threadCount(),
+                                                           std::vector<size_t>(reader.blocks().size(), 0));
+
+            pool.run(chunks.size(), [&](size_t task, int worker)
+            {
+                const ScanChunk& chunk = chunks[task];
+                const MemBlock& mb = *reader.blocks()[chunk.block];
+                size_t firstIndex = chunk.begin / mb.stride();
+                size_t lastIndex = std::min((chunk.end + mb.stride() - 1) / mb.stride(), mb.elementCount(chunk.limit));
+
+                // nothing is compared, so values can be stored right away
+                if (m_hasSnapshot)
+                {
+                    reader.store(chunk);
+                }
+                workerMatches[worker][chunk.block] += lastIndex > firstIndex ? lastIndex - firstIndex : 0;
+            });
+
+            for (size_t i = 0; i < reader.blocks().size(); i++)
+            {
+                for (auto& matches : workerMatches)
+                {
+                    reader.blocks()[i]->matches() += matches[i];
+                }
+            }
+        }
+    }
+    MemBlock::removeDead(memblocks);
+
+    return memblocks;
+}
+
+/**
+ * \brief Read the live pages of all dense blocks batch by batch and filter each batch in parallel, the pass of every
+ * numeric scanner. Match counts are collected per worker and merged once the batch is done. Unaligned values reach
+ * into the next chunk, so for them previous values are only replaced after the whole batch has been filtered. Blocks
+ * without matches are dropped at the end.
+ * \param pool Threads filtering the chunks
+ * \param filterChunk Filters one chunk of a dense block on a worker and returns its number of matches
+ * \param isMatch Decides for the survivors of sparse blocks, from the bits of new and previous value
+ */
+void ScanSession::scanBlocks(ThreadPool& pool, const ChunkFilter& filterChunk, const MatchFilter& isMatch)
+{
+    if (m_memblocks.empty())
+    {
+        return;
+    }
+
+    bool aligned = (m_memblocks[0].stride() == m_dataSize);
+    BlockReader reader(m_pHandle, m_memblocks, aligned ? 0 : m_dataSize - 1);
+
+    // blocks turning sparse below already hold this scan's values, so sparse blocks are filtered first
+    updateSparse(isMatch);
+    for (auto& mb : m_memblocks)
+    {
+        if (!mb.isSparse())
+        {
+            mb.matches() = 0;
+        }
+    }
+
+    while (reader.next())
+    {
+        std::vector<ScanChunk> chunks = reader.chunks();
+        std::vector<std::vector<size_t>> workerMatches(pool.threadCount(), 
+                                                       std::vector<size_t>(reader.blocks().size(), 0));
+
+        pool.run(chunks.size(), [&](size_t task, int worker)
+        {
+            const ScanChunk& chunk = chunks[task];
+            workerMatches[worker][chunk.block] += filterChunk(*reader.blocks()[chunk.block], chunk, worker);
+            if (aligned)
+            {
+                reader.store(chunk);
+            }
+        });
+        if (!aligned)
+        {
+            pool.run(chunks.size(), [&](size_t task, int) { reader.store(chunks[task]); });
+        }
+
+        for (size_t i = 0; i < reader.blocks().size(); i++)
+        {
+            for (auto& matches : workerMatches)
+            {
+                reader.blocks()[i]->matches() += matches[i];
+            }
+        }
+    }
+
+    for (auto& mb : m_memblocks)
+    {
+        if (mb.shouldBeSparse())
+        {
+            mb.makeSparse();
+        }
+    }
+    MemBlock::removeDead(m_memblocks);
+    m_isScanned = true;
+}
+
+/**
+ * \brief Filter the survivors of all sparse blocks. Survivors that no longer match, or couldn't be read, get address 0
+ * and are erased by BlockReader::readSparse.
+ */
+void ScanSession::updateSparse(const MatchFilter& isMatch)
+{
+    BlockReader::readSparse(m_pHandle, m_memblocks, [&](const SparseSpan& span, const ReadRequest& read)
+    {
+        MemBlock& mb = m_memblocks[span.block];
+
+        for (size_t i = span.firstMatch; i < span.lastMatch; i++)
+        {
+            SparseMatch& match = mb.sparseMatches()[i];
+            size_t offset = match.addr - span.begin;
+            bool matched = false;
+
+            if (offset + mb.dataSize() <= read.bytesRead)
+            {
+                int64_t tempVal = MemBlock::toInt(read.buffer + offset, mb.dataSize());
+
+                matched = isMatch(tempVal, match.value);
+                match.value = tempVal;
+            }
+
+            if (!matched)
+            {
+                match.addr = 0;
+            }
+        }
+    });
+}
\ No newline at end of file
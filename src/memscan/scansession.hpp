@@ -0,0 +1,92 @@
+#pragma once
+#include "blockreader.hpp"
+#include "memblock.hpp"
+#include "process.hpp"
+#include "regionfilter.hpp"
+#include "threadpool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * \brief Outcome of ScanSession::refreshRegions. Retired blocks took their remaining matches with them, added
+ * regions start with every readable value as a match.
+ */
+struct RegionRefresh
+{
+    size_t keptBlocks;
+    size_t addedRegions;
+    size_t addedBytes;
+    size_t addedMatches;
+    size_t retiredBlocks;
+    size_t retiredBytes;
+    size_t retiredMatches;
+};
+
+/**
+ * \brief State of one scan: the opened process and its MemBlocks.
+ *
+ * A session exists once and is shared by Scanner and the typed scanners through std::shared_ptr, so the region-sized
+ * buffers of the MemBlocks are never copied. The process handle is owned by the session and closed exactly once, 
+ * when the last owner lets go of it.
+ * \param pHandle Opened process handle, the session takes ownership
+ * \param processId Id of the process
+ * \param dataSize Data size of the values in bytes
+ *
+ * The session also keeps the filtered region table it was created from, sorted by address, so refreshRegions() can
+ * tell regions that were mapped since from those whose blocks merely ran out of matches.
+ */
+class ScanSession
+{
+    public:
+        typedef std::function<size_t(MemBlock& mb, const ScanChunk& chunk, int worker)> ChunkFilter;
+        typedef std::function<bool(int64_t val, int64_t prevVal)> MatchFilter;
+
+        ScanSession(ProcessHandle pHandle, int processId, int dataSize);
+        ~ScanSession();
+
+        ScanSession(const ScanSession&) = delete;
+        ScanSession& operator=(const ScanSession&) = delete;
+
+        static std::shared_ptr<ScanSession> open(int processId, int dataSize, bool unaligned,
+                                                 const RegionFilter& filter = RegionFilter(), bool hasSnapshot = true);
+
+        const ProcessHandle&         pHandle()   const { return m_pHandle; }
+        const int&                   processId() const { return m_processId; }
+              std::vector<MemBlock>& memblocks()       { return m_memblocks; }
+        const std::vector<MemBlock>& memblocks() const { return m_memblocks; }
+        const int&                   dataSize()  const { return m_dataSize; }
+              RegionFilter&          regionFilter()       { return m_regionFilter; }
+        const RegionFilter&          regionFilter() const { return m_regionFilter; }
+              std::vector<Region>&   regions()            { return m_regions; }
+        const std::vector<Region>&   regions()      const { return m_regions; }
+              bool&                  unaligned()          { return m_unaligned; }
+        const bool&                  unaligned()    const { return m_unaligned; }
+              bool&                  hasSnapshot()        { return m_hasSnapshot; }
+        const bool&                  hasSnapshot()  const { return m_hasSnapshot; }
+              bool&                  isScanned()          { return m_isScanned; }
+        const bool&                  isScanned()    const { return m_isScanned; }
+
+        size_t matches() const;
+        RegionRefresh refreshRegions(ThreadPool& pool);
+        void scanBlocks(ThreadPool& pool, const ChunkFilter& filterChunk, const MatchFilter& isMatch);
+
+    private:
+        ProcessHandle m_pHandle;
+        int m_processId;
+        std::vector<MemBlock> m_memblocks;
+        int m_dataSize;
+        RegionFilter m_regionFilter;
+        std::vector<Region> m_regions;
+        bool m_unaligned;
+        // blocks keep a copy of their region, false for scans that never compare with previous values
+        bool m_hasSnapshot;
+        // the blocks hold values read from the process, relative conditions have something to compare with
+        bool m_isScanned;
+
+        std::vector<MemBlock> readAdded(const std::vector<Region>& added, ThreadPool& pool);
+        void updateSparse(const MatchFilter& isMatch);
+};
\ No newline at end of file
@@ -0,0 +1,636 @@
+#include "floatscanner.hpp"
+#include "intscanner.hpp"
+#include "matchpage.hpp"
+#include "server.hpp"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    /**
+     * \brief Little endian field of a payload
+     */
+    template <typename T>
+    T field(const char* payload, size_t offset)
+    {
+        T value;
+        std::memcpy(&value, payload + offset, sizeof(value));
+        return value;
+    }
+
+    template <typename T>
+    void append(std::string& out, T value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    // payload sizes of the fixed size requests, data of OP_WRITE and OP_FREEZE follows the address
+    const size_t openSize = 7;
+    const size_t pidSize = 4;
+    const size_t scanSize = 21;
+    const size_t matchesSize = 20;
+    const size_t readSize = 16;
+    const size_t addrSize = 12;
+}
+
+Server::Server(const std::string& path, int threadCount, std::chrono::microseconds freezeInterval,
+               const RegionFilter& regionFilter)
+    : m_path(path)
+    , m_pool(threadCount)
+    , m_freezeInterval(freezeInterval)
+    , m_regionFilter(regionFilter)
+    , m_listener(-1)
+    , m_stopping(false)
+{}
+
+#ifdef _WIN32
+
+/**
+ * \brief Unix sockets aren't supported on Windows builds
+ */
+bool Server::run()
+{
+    return false;
+}
+
+void Server::stop()
+{}
+
+void Server::Connection::send(size_t)
+{
+    failed = true;
+}
+
+#else
+
+namespace
+{
+    /**
+     * \brief Remove a socket left behind at path. Anything else there is kept, bind then fails on it.
+     */
+    void removeSocket(const std::string& path)
+    {
+        struct stat st;
+
+        if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+        {
+            unlink(path.c_str());
+        }
+    }
+}
+
+/**
+ * \brief Listen on the socket and serve every client from a thread of its own until stop is called. Running out of
+ * file descriptors or memory pauses accepting for a moment, other errors of the socket end the server.
+ * \return False if the socket can't be created or fails, true after stop once every client is gone
+ */
+bool Server::run()
+{
+    sockaddr_un addr {};
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (listener < 0 || m_path.size() >= sizeof(addr.sun_path))
+    {
+        return false;
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, m_path.c_str(), m_path.size() + 1);
+    removeSocket(m_path);
+    // sessions can read and write the memory of other processes, only the owner may connect. The mode is set before
+    // listen, so no client can connect in between.
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || chmod(m_path.c_str(), 0600) != 0 ||
+        listen(listener, SOMAXCONN) != 0)
+    {
+        ::close(listener);
+        return false;
+    }
+
+    m_listener = listener;
+
+    bool failed = false;
+    while (!m_stopping)
+    {
+        {
+            // stop may come from a signal handler and can't notify, so the wait looks at m_stopping now and then
+            std::unique_lock<std::mutex> lock(m_clientsMutex);
+            if (!m_clientDone.wait_for(lock, std::chrono::milliseconds(100), 
+                                       [this] { return m_clients.size() < maxClients; }))
+            {
+                continue;
+            }
+        }
+
+        int client = accept(listener, nullptr, nullptr);
+        if (client >= 0)
+        {
+            std::lock_guard<std::mutex> lock(m_clientsMutex);
+            m_clients.insert(client);
+            std::thread(&Server::serveClient, this, client).detach();
+        }
+        else if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        else if (errno != EINTR && errno != ECONNABORTED && !m_stopping)
+        {
+            failed = true;
+            break;
+        }
+    }
+
+    m_listener = -1;
+    ::close(listener);
+    removeSocket(m_path);
+
+    // wake the clients waiting for requests, the ones in the middle of a request answer it first
+    std::unique_lock<std::mutex> lock(m_clientsMutex);
+    for (int client : m_clients)
+    {
+        shutdown(client, SHUT_RDWR);
+    }
+    m_clientDone.wait(lock, [this] { return m_clients.empty(); });
+
+    return !failed;
+}
+
+/**
+ * \brief Make run return. Only sets a flag and shuts the listening socket down, so it can be called from a signal
+ * handler.
+ */
+void Server::stop()
+{
+    m_stopping = true;
+
+    int listener = m_listener;
+    if (listener >= 0)
+    {
+        shutdown(listener, SHUT_RDWR);
+    }
+}
+
+/**
+ * \brief Send the pending responses once there are at least threshold bytes of them
+ */
+void Server::Connection::send(size_t threshold)
+{
+    if (failed || out.size() < threshold || out.empty())
+    {
+        return;
+    }
+
+    for (size_t sent = 0; sent < out.size();)
+    {
+        ssize_t size = ::send(socket, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+        if (size <= 0)
+        {
+            failed = true;
+            break;
+        }
+        sent += size;
+    }
+    out.clear();
+}
+
+/**
+ * \brief Answer the requests of one client until it disconnects. Every complete request in the receive buffer is
+ * answered before the responses are sent, so pipelined requests share sends.
+ */
+void Server::serveClient(int client)
+{
+    Connection conn {client, "", false};
+    std::vector<char> in;
+    char buffer[64 << 10];
+
+    while (!conn.failed)
+    {
+        ssize_t size = recv(client, buffer, sizeof(buffer), 0);
+        if (size <= 0)
+        {
+            break;
+        }
+        in.insert(in.end(), buffer, buffer + size);
+
+        size_t offset = 0;
+        while (in.size() - offset >= sizeof(FrameHeader))
+        {
+            FrameHeader request = field<FrameHeader>(in.data(), offset);
+
+            if (request.size > maxFrameSize)
+            {
+                conn.failed = true;
+                break;
+            }
+            if (in.size() - offset - sizeof(FrameHeader) < request.size)
+            {
+                break;
+            }
+
+            handle(request, in.data() + offset + sizeof(FrameHeader), conn);
+            offset += sizeof(FrameHeader) + request.size;
+        }
+
+        in.erase(in.begin(), in.begin() + offset);
+        conn.send(0);
+    }
+
+    {
+        // the socket stays open until it's gone from m_clients, so run never shuts down a reused descriptor
+        std::lock_guard<std::mutex> lock(m_clientsMutex);
+        m_clients.erase(client);
+        m_clientDone.notify_all();
+    }
+    ::close(client);
+}
+
+#endif
+
+void Server::reply(const FrameHeader& request, ServerStatus status, const void* payload, size_t size, 
+                   Connection& conn)
+{
+    FrameHeader header {static_cast<uint32_t>(size), request.id, request.opcode, static_cast<uint16_t>(status)};
+
+    append(conn.out, header);
+    conn.out.append(static_cast<const char*>(payload), size);
+    conn.send(flushBytes);
+}
+
+std::shared_ptr<Server::ServerSession> Server::findSession(int processId)
+{
+    std::lock_guard<std::mutex> lock(m_sessionsMutex);
+    auto it = m_sessions.find(processId);
+
+    return it == m_sessions.end() ? nullptr : it->second;
+}
+
+void Server::handle(const FrameHeader& request, const char* payload, Connection& conn)
+{
+    if (request.opcode == OP_OPEN)
+    {
+        open(request, payload, conn);
+        return;
+    }
+    if (request.opcode < OP_CLOSE || request.opcode > OP_REFRESH)
+    {
+        reply(request, STATUS_UNKNOWN_OPCODE, nullptr, 0, conn);
+        return;
+    }
+    if (request.size < pidSize)
+    {
+        reply(request, STATUS_BAD_REQUEST, nullptr, 0, conn);
+        return;
+    }
+
+    int processId = field<int32_t>(payload, 0);
+    if (request.opcode == OP_CLOSE)
+    {
+        close(request, processId, conn);
+        return;
+    }
+
+    std::shared_ptr<ServerSession> session = findSession(processId);
+    if (!session)
+    {
+        reply(request, STATUS_NO_SESSION, nullptr, 0, conn);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(session->mutex);
+    switch (request.opcode)
+    {
+        case OP_SCAN:
+        case OP_FILTER:
+            scan(request, *session, payload, conn);
+            break;
+        case OP_MATCHES:
+            matches(request, *session, payload, conn);
+            break;
+        case OP_READ:
+            read(request, *session, payload, conn);
+            break;
+        case OP_WRITE:
+            write(request, *session, payload, conn);
+            break;
+        case OP_FREEZE:
+            freeze(request, *session, payload, conn);
+            break;
+        case OP_REFRESH:
+            refresh(request, *session, conn);
+            break;
+    }
+}
+
+/**
+ * \brief Attach to the session of a pid, or create it. An existing session has to have the same value type.
+ * Payload: int32 pid, uint8 type (0 integer, 1 float), uint8 data size, uint8 flags (1 unaligned).
+ * Response: uint64 matches, uint8 1 if the session was created.
+ */
+void Server::open(const FrameHeader& request, const char* payload, Connection& conn)
+{
+    if (request.size < openSize)
+    {
+        reply(request, STATUS_BAD_REQUEST, nullptr, 0, conn);
+        return;
+    }
+
+    int processId = field<int32_t>(payload, 0);
+    bool isFloat = payload[4] == 1;
+    int dataSize = static_cast<uint8_t>(payload[5]);
+    bool unaligned = payload[6] & 1;
+    bool validSize = isFloat ? dataSize == 4 || dataSize == 8 
+                             : dataSize == 1 || dataSize == 2 || dataSize == 4 || dataSize == 8;
+    std::string response;
+
+    if (!validSize || (payload[4] != 0 && payload[4] != 1))
+    {
+        reply(request, STATUS_BAD_REQUEST, nullptr, 0, conn);
+        return;
+    }
+
+    std::shared_ptr<ServerSession> session = findSession(processId);
+    // a session that lost the race below is freed here, after the lock is released
+    std::shared_ptr<ServerSession> opened;
+    bool created = false;
+
+    if (!session)
+    {
+        // reading the regions and allocating the blocks takes a while, requests on other pids go on meanwhile
+        std::shared_ptr<ScanSession> scan = ScanSession::open(processId, dataSize, unaligned, m_regionFilter);
+        if (!scan)
+        {
+            reply(request, STATUS_PROCESS_ERROR, nullptr, 0, conn);
+            return;
+        }
+
+        opened = std::make_shared<ServerSession>();
+        opened->scan = scan;
+        opened->isFloat = isFloat;
+        opened->unaligned = unaligned;
+
+        // another connection may have opened the pid in the meantime, then its session wins and ours is dropped
+        std::lock_guard<std::mutex> lock(m_sessionsMutex);
+        std::shared_ptr<ServerSession>& slot = m_sessions[processId];
+        if (!slot)
+        {
+            slot = opened;
+            created = true;
+        }
+        session = slot;
+    }
+
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (session->isFloat != isFloat || session->scan->dataSize() != dataSize || session->unaligned != unaligned)
+    {
+        reply(request, STATUS_CONFLICT, nullptr, 0, conn);
+        return;
+    }
+
+    append<uint64_t>(response, session->scan->matches());
+    append<uint8_t>(response, created);
+    reply(request, STATUS_OK, response.data(), response.size(), conn);
+}
+
+/**
+ * \brief Drop the session of a pid, for all connections. Payload: int32 pid.
+ */
+void Server::close(const FrameHeader& request, int processId, Connection& conn)
+{
+    std::shared_ptr<ServerSession> session;
+
+    {
+        std::lock_guard<std::mutex> lock(m_sessionsMutex);
+        auto it = m_sessions.find(processId);
+        if (it == m_sessions.end())
+        {
+            reply(request, STATUS_NO_SESSION, nullptr, 0, conn);
+            return;
+        }
+        session = it->second;
+        m_sessions.erase(it);
+    }
+
+    // requests of other connections that still hold the session finish first
+    std::lock_guard<std::mutex> lock(session->mutex);
+    session->freezer.reset();
+    reply(request, STATUS_OK, nullptr, 0, conn);
+}
+
+/**
+ * \brief OP_SCAN starts over with the current regions of the process and drops frozen values, OP_FILTER narrows the
+ * matches down. Payload: int32 pid, uint8 condition, int64 val, int64 val2, for floats double low and high (both
+ * included). Response: uint64 matches, uint64 microseconds taken.
+ *
+ * A condition that compares with previous values needs a session that was read before. If it wasn't (OP_SCAN, or
+ * OP_FILTER right after OP_OPEN), all values are read unconditionally first, like plans that start with a filter.
+ */
+void Server::scan(const FrameHeader& request, ServerSession& session, const char* payload, Connection& conn)
+{
+    if (request.size < scanSize || payload[4] < COND_UNCONDITIONAL || payload[4] > COND_BITMASK ||
+        (session.isFloat && payload[4] > COND_UNCHANGED))
+    {
+        reply(request, STATUS_BAD_REQUEST, nullptr, 0, conn);
+        return;
+    }
+
+    Condition condition = static_cast<Condition>(payload[4]);
+    auto start = std::chrono::steady_clock::now();
+    std::string response;
+
+    if (request.opcode == OP_SCAN)
+    {
+        std::shared_ptr<ScanSession> scan = ScanSession::open(session.scan->processId(), session.scan->dataSize(),
+                                                              session.unaligned, m_regionFilter);
+        if (!scan)
+        {
+            reply(request, STATUS_PROCESS_ERROR, nullptr, 0, conn);
+            return;
+        }
+
+        // the freezer holds the old session and with it all of its blocks
+        session.freezer.reset();
+        session.scan = scan;
+    }
+
+    bool needsBaseline = !session.scan->isScanned() && MemBlock::isRelative(condition);
+
+    if (session.isFloat)
+    {
+        FloatScanner scanner(session.scan, m_pool);
+        FloatRange range = FloatRange::between(field<double>(payload, 5), field<double>(payload, 13));
+
+        if (needsBaseline)
+        {
+            scanner.updateScan(COND_UNCONDITIONAL, range);
+        }
+        scanner.updateScan(condition, range);
+    }
+    else
+    {
+        IntScanner scanner(session.scan, m_pool);
+
+        if (needsBaseline)
+        {
+            scanner.updateScan(COND_UNCONDITIONAL, 0);
+        }
+        scanner.updateScan(condition, field<int64_t>(payload, 5), field<int64_t>(payload, 13));
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    append<uint64_t>(response, session.scan->matches());
+    append<uint64_t>(response, elapsed.count());
+    reply(request, STATUS_OK, response.data(), response.size(), conn);
+}
+
+/**
+ * \brief Stream matches [first, first + limit) with their values as of the last scan and as read now, limit 0 for all.
+ * Payload: int32 pid, uint64 first, uint64 limit. Every STATUS_CONTINUE frame holds up to matchesPerFrame entries
+ * of uint64 address, previous, current, uint64 flags (1 if current could be read). Previous and current are int64 for
+ * integer sessions and double for float sessions, floats widened. The last frame is STATUS_OK with uint64 total
+ * matches and uint64 entries sent.
+ */
+void Server::matches(const FrameHeader& request, ServerSession& session, const char* payload, Connection& conn)
+{
+    if (request.size < matchesSize)
+    {
+        reply(request, STATUS_BAD_REQUEST, nullptr, 0, conn);
+        return;
+    }
+
+    size_t total = session.scan->matches();
+    size_t first = field<uint64_t>(payload, 4);
+    size_t count = field<uint64_t>(payload, 12);
+    size_t last = count == 0 || count > total - std::min(first, total) ? total : first + count;
+    int dataSize = session.scan->dataSize();
+    ProcessHandle pHandle = session.scan->pHandle();
+    std::string frame;
+    MatchCursor cursor {0, 0};
+    size_t sent = 0;
+
+    for (size_t pageFirst = first; pageFirst < last && !conn.failed; pageFirst += matchesPerFrame)
+    {
+        const std::vector<MemBlock>& memblocks = session.scan->memblocks();
+        size_t limit = std::min(matchesPerFrame, last - pageFirst);
+        // pages after the first go on from the cursor of the previous one
+        MatchPage page = pageFirst == first ? MatchPage(pHandle, memblocks, first, limit, dataSize, true)
+                                            : MatchPage(pHandle, memblocks, cursor, limit, dataSize, true);
+
+        cursor = page.next();
+
+        frame.clear();
+        for (auto& entry : page.entries())
+        {
+            int64_t previous = MemBlock::toInt(entry.snapshot, dataSize);
+            int64_t current = entry.current ? MemBlock::toInt(entry.current, dataSize) : 0;
+
+            append<uint64_t>(frame, entry.addr);
+            if (session.isFloat)
+            {
+                append<double>(frame, FloatScanner::toDouble(previous, dataSize));
+                append<double>(frame, entry.current ? FloatScanner::toDouble(current, dataSize) : 0);
+            }
+            else
+            {
+                append<int64_t>(frame, previous);
+                append<int64_t>(frame, current);
+            }
+            append<uint64_t>(frame, entry.current ? 1 : 0);
+        }
+        sent += page.entries().size();
+        reply(request, STATUS_CONTINUE, frame.data(), frame.size(), conn);
+    }
+
+    frame.clear();
+    append<uint64_t>(frame, total);
+    append<uint64_t>(frame, sent);
+    reply(request, STATUS_OK, frame.data(), frame.size(), conn);
+}
+
+/**
+ * \brief Payload: int32 pid, uint64 address, uint32 size. Response: the bytes that could be read.
+ */
+void Server::read(const FrameHeader& request, ServerSession& session, const char* payload, Connection& conn)
+{
+    if (request.size < readSize || field<uint32_t>(payload, 12) > maxFrameSize)
+    {
+        reply(request, STATUS_BAD_REQUEST, nullptr, 0, conn);
+        return;
+    }
+
+    std::vector<char> buffer(field<uint32_t>(payload, 12));
+    const void* addr = reinterpret_cast<const void*>(field<uint64_t>(payload, 4));
+    size_t bytesRead = Process::read(session.scan->pHandle(), addr, buffer.data(), buffer.size());
+    reply(request, STATUS_OK, buffer.data(), bytesRead, conn);
+}
+
+/**
+ * \brief Payload: int32 pid, uint64 address, the bytes to write
+ */
+void Server::write(const FrameHeader& request, ServerSession& session, const char* payload, Connection& conn)
+{
+    if (request.size < addrSize)
+    {
+        reply(request, STATUS_BAD_REQUEST, nullptr, 0, conn);
+        return;
+    }
+
+    bool written = Process::write(session.scan->pHandle(), field<uint64_t>(payload, 4), payload + addrSize, 
+                                  request.size - addrSize);
+    reply(request, written ? STATUS_OK : STATUS_PROCESS_ERROR, nullptr, 0, conn);
+}
+
+/**
+ * \brief Payload: int32 pid, uint64 address, the bytes to hold the address at. Without bytes the address is unfrozen.
+ */
+void Server::freeze(const FrameHeader& request, ServerSession& session, const char* payload, Connection& conn)
+{
+    if (request.size < addrSize)
+    {
+        reply(request, STATUS_BAD_REQUEST, nullptr, 0, conn);
+        return;
+    }
+
+    if (!session.freezer)
+    {
+        session.freezer = std::make_unique<Freezer>(session.scan, m_freezeInterval);
+    }
+
+    uintptr_t addr = field<uint64_t>(payload, 4);
+    if (request.size == addrSize)
+    {
+        session.freezer->unfreeze(addr);
+    }
+    else
+    {
+        session.freezer->freeze(addr, payload + addrSize, request.size - addrSize);
+    }
+    reply(request, STATUS_OK, nullptr, 0, conn);
+}
+
+/**
+ * \brief Add the regions mapped since the last scan or refresh and retire the blocks whose memory is gone. Payload:
+ * int32 pid. Response: uint64 blocks kept, regions added, bytes added, matches added, blocks retired, bytes retired,
+ * matches retired and matches left.
+ */
+void Server::refresh(const FrameHeader& request, ServerSession& session, Connection& conn)
+{
+    RegionRefresh refresh = session.scan->refreshRegions(m_pool);
+    std::string response;
+
+    for (size_t count : {refresh.keptBlocks, refresh.addedRegions, refresh.addedBytes, refresh.addedMatches,
+                         refresh.retiredBlocks, refresh.retiredBytes, refresh.retiredMatches, session.scan->matches()})
+    {
+        append<uint64_t>(response, count);
+    }
+    reply(request, STATUS_OK, response.data(), response.size(), conn);
+}
\ No newline at end of file
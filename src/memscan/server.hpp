@@ -0,0 +1,139 @@
+#pragma once
+#include "freezer.hpp"
+#include "regionfilter.hpp"
+#include "scansession.hpp"
+#include "threadpool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+enum ServerOpcode
+{
+    OP_OPEN = 1,
+    OP_CLOSE,
+    OP_SCAN,
+    OP_FILTER,
+    OP_MATCHES,
+    OP_READ,
+    OP_WRITE,
+    OP_FREEZE,
+    OP_REFRESH
+};
+
+enum ServerStatus
+{
+    STATUS_OK = 0,
+    // more frames of the same request follow
+    STATUS_CONTINUE,
+    STATUS_BAD_REQUEST,
+    STATUS_NO_SESSION,
+    STATUS_PROCESS_ERROR,
+    STATUS_CONFLICT,
+    STATUS_UNKNOWN_OPCODE
+};
+
+/**
+ * \brief Long running scanner that keeps sessions of many processes in memory and serves them over a Unix socket.
+ *
+ * Requests and responses are frames of a FrameHeader and size bytes of payload, all little endian. Clients may send
+ * any number of requests without waiting, every connection answers its requests in order with the id of the request,
+ * and responses of requests that arrived together go out with one send. Payloads start with the pid of the session
+ * except for OP_OPEN (see the README for the layout of each).
+ *
+ * There is one session per pid, shared by all connections. Requests on one session run one after another, requests on
+ * different sessions in parallel. Scans share one thread pool, a scan that arrives while the pool is busy works on its
+ * own thread until the pool is free, so scans neither wait for each other nor start threads of their own. At most
+ * maxClients connections are served at a time, further clients wait in the backlog of the socket.
+ * \param path Path of the socket, only accessible by the owner. An existing socket there is replaced, other files are
+ * kept and make run fail.
+ * \param threadCount Threads of the scan pool
+ * \param freezeInterval Interval of the freezers of the sessions
+ * \param regionFilter Regions the sessions are limited to
+ */
+class Server
+{
+    public:
+        Server(const std::string& path, int threadCount, std::chrono::microseconds freezeInterval,
+               const RegionFilter& regionFilter);
+
+        bool run();
+        void stop();
+
+        /**
+         * \brief Header of every request and response frame
+         */
+        struct FrameHeader
+        {
+            uint32_t size;
+            uint32_t id;
+            uint16_t opcode;
+            uint16_t status;
+        };
+
+        const static inline size_t maxFrameSize = 16 << 20;
+        // matches per OP_MATCHES frame
+        const static inline size_t matchesPerFrame = 4096;
+        const static inline size_t maxClients = 64;
+
+    private:
+        /**
+         * \brief Client socket and the responses not sent yet
+         */
+        struct Connection
+        {
+            int socket;
+            std::string out;
+            bool failed;
+
+            void send(size_t threshold);
+        };
+
+        struct ServerSession
+        {
+            std::mutex mutex;
+            std::shared_ptr<ScanSession> scan;
+            std::unique_ptr<Freezer> freezer;
+            bool isFloat;
+            bool unaligned;
+        };
+
+        std::string m_path;
+        ThreadPool m_pool;
+        std::chrono::microseconds m_freezeInterval;
+        RegionFilter m_regionFilter;
+        std::map<int, std::shared_ptr<ServerSession>> m_sessions;
+        std::mutex m_sessionsMutex;
+        std::atomic<int> m_listener;
+        std::atomic<bool> m_stopping;
+        // sockets of the connected clients, each served by a detached thread
+        std::set<int> m_clients;
+        std::mutex m_clientsMutex;
+        std::condition_variable m_clientDone;
+
+        void serveClient(int client);
+        void handle(const FrameHeader& request, const char* payload, Connection& conn);
+        std::shared_ptr<ServerSession> findSession(int processId);
+
+        void open(const FrameHeader& request, const char* payload, Connection& conn);
+        void close(const FrameHeader& request, int processId, Connection& conn);
+        void scan(const FrameHeader& request, ServerSession& session, const char* payload, Connection& conn);
+        void matches(const FrameHeader& request, ServerSession& session, const char* payload, Connection& conn);
+        void read(const FrameHeader& request, ServerSession& session, const char* payload, Connection& conn);
+        void write(const FrameHeader& request, ServerSession& session, const char* payload, Connection& conn);
+        void freeze(const FrameHeader& request, ServerSession& session, const char* payload, Connection& conn);
+        void refresh(const FrameHeader& request, ServerSession& session, Connection& conn);
+
+        static void reply(const FrameHeader& request, ServerStatus status, const void* payload, size_t size, 
+                          Connection& conn);
+
+        // responses are sent once this much is pending, or when no complete request is left
+        const static inline size_t flushBytes = 64 << 10;
+};
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "mappedfile.hpp"
+#include "memblock.hpp"
+#include "scanner.hpp"
+#include "sessionfile.hpp"
+
+#ifdef _WIN32
+#include <winbase.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+    /**
+     * \brief Write data at the next page boundary of the stream
+     * \return Offset the data starts at
+     */
+    uint64_t writeSection(std::ofstream& out, const void* data, size_t size, size_t pageSize)
+    {
+        static const char zeros[4096] = {0};
+        uint64_t offset = out.tellp();
+
+        if (offset % pageSize != 0)
+        {
+            out.write(zeros, pageSize - offset % pageSize);
+            offset += pageSize - offset % pageSize;
+        }
+        out.write(static_cast<const char*>(data), size);
+
+        return offset;
+    }
+
+    bool inFile(uint64_t offset, uint64_t size, uint64_t fileSize)
+    {
+        return offset <= fileSize && size <= fileSize - offset;
+    }
+
+    /**
+     * \brief Whether the Scanner can continue a session of this type, the values are cast to its enums
+     */
+    bool isValidType(uint32_t dataSize, uint32_t scanType, uint32_t encoding)
+    {
+        bool validSize = dataSize == 1 || dataSize == 2 || dataSize == 4 || dataSize == 8;
+
+        return validSize && scanType <= SCAN_AOB && encoding <= ENC_UTF16LE &&
+               (scanType != SCAN_FLOAT || dataSize == 4 || dataSize == 8);
+    }
+
+    /**
+     * \brief Replace to with from in one step, to is never missing in between
+     */
+    bool replaceFile(const std::string& from, const std::string& to)
+    {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+}
+
+/**
+ * \brief Write the session to path. The file is written next to path and renamed over it when complete, so a crash
+ * never leaves a half written session behind and path always holds either the old or the new session. On POSIX a
+ * session loaded from path keeps mapping the old file; Windows refuses to replace a file that is still mapped, saving
+ * over the file of a loaded session fails there.
+ * \return False if the file couldn't be written or replaced
+ */
+bool SessionFile::save(const ScanSession& session, const SessionInfo& info, const std::string& path)
+{
+    const std::vector<MemBlock>& memblocks = session.memblocks();
+    std::string tempPath = path + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    std::vector<BlockEntry> table(memblocks.size());
+    std::vector<RegionEntry> regions;
+    std::string paths;
+    FileHeader header {};
+
+    if (!out)
+    {
+        return false;
+    }
+
+    // header and table are written again once the offsets are known
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    header.tableOffset = writeSection(out, table.data(), table.size() * sizeof(BlockEntry), pageSize);
+    header.valueOffset = writeSection(out, info.value.data(), info.value.size(), pageSize);
+    header.valueSize = info.value.size();
+
+    for (auto& region : session.regions())
+    {
+        regions.push_back({reinterpret_cast<uintptr_t>(region.addr), region.size, paths.size(),
+                           static_cast<uint32_t>(region.path.size()), static_cast<uint32_t>(region.kind)});
+        paths += region.path;
+    }
+    header.regionCount = regions.size();
+    header.regionOffset = writeSection(out, regions.data(), regions.size() * sizeof(RegionEntry), pageSize);
+    header.pathOffset = writeSection(out, paths.data(), paths.size(), pageSize);
+    header.pathSize = paths.size();
+
+    for (size_t i = 0; i < memblocks.size(); i++)
+    {
+        const MemBlock& mb = memblocks[i];
+        BlockEntry& entry = table[i];
+
+        entry.addr = reinterpret_cast<uintptr_t>(mb.addr());
+        entry.size = mb.size();
+        entry.matches = mb.matches();
+        entry.dataSize = mb.dataSize();
+        entry.stride = mb.stride();
+        entry.maskSize = mb.searchMask().size();
+        entry.maskOffset = writeSection(out, mb.searchMask().data(), entry.maskSize, pageSize);
+        entry.bufferSize = mb.buffer().size();
+        entry.bufferOffset = writeSection(out, mb.buffer().data(), entry.bufferSize, pageSize);
+        entry.sparseCount = mb.sparseMatches().size();
+        entry.sparseOffset = writeSection(out, mb.sparseMatches().data(), entry.sparseCount * sizeof(SparseMatch),
+                                          pageSize);
+    }
+
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.headerSize = sizeof(FileHeader);
+    header.fileSize = out.tellp();
+    header.processId = session.processId();
+    header.dataSize = session.dataSize();
+    header.scanType = info.scanType;
+    header.encoding = info.encoding;
+    header.flags = (info.ignoreCase ? flagIgnoreCase : 0) | (info.unaligned ? flagUnaligned : 0);
+    header.blockCount = table.size();
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.seekp(header.tableOffset);
+    out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(BlockEntry));
+    out.close();
+
+    if (!out || !replaceFile(tempPath, path))
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Map a saved session back in and reopen its process
+ * \param info Filled with the Scanner state of the session
+ * \return Session, or nullptr if the file isn't a valid session or the process can't be opened
+ */
+std::shared_ptr<ScanSession> SessionFile::load(const std::string& path, SessionInfo& info)
+{
+    auto file = std::make_shared<MappedFile>(path);
+    FileHeader header;
+
+    if (!file->isValid() || file->size() < sizeof(header))
+    {
+        return nullptr;
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version || 
+        header.headerSize != sizeof(FileHeader) || header.fileSize != file->size() ||
+        !isValidType(header.dataSize, header.scanType, header.encoding) ||
+        header.blockCount > file->size() / sizeof(BlockEntry) ||
+        !inFile(header.tableOffset, header.blockCount * sizeof(BlockEntry), file->size()) || 
+        !inFile(header.valueOffset, header.valueSize, file->size()) ||
+        header.regionCount > file->size() / sizeof(RegionEntry) ||
+        !inFile(header.regionOffset, header.regionCount * sizeof(RegionEntry), file->size()) ||
+        !inFile(header.pathOffset, header.pathSize, file->size()))
+    {
+        return nullptr;
+    }
+
+    ProcessHandle pHandle = Process::open(header.processId);
+    if (!Process::isValid(pHandle))
+    {
+        return nullptr;
+    }
+
+    auto session = std::make_shared<ScanSession>(pHandle, header.processId, header.dataSize);
+    const BlockEntry* table = reinterpret_cast<const BlockEntry*>(file->data() + header.tableOffset);
+    const RegionEntry* regions = reinterpret_cast<const RegionEntry*>(file->data() + header.regionOffset);
+
+    for (size_t i = 0; i < header.regionCount; i++)
+    {
+        const RegionEntry& entry = regions[i];
+        const char* paths = file->data() + header.pathOffset;
+
+        if (!inFile(entry.pathOffset, entry.pathSize, header.pathSize) || (i > 0 && entry.addr <= regions[i-1].addr))
+        {
+            return nullptr;
+        }
+        session->regions().push_back({reinterpret_cast<char*>(entry.addr), entry.size,
+                                      static_cast<RegionKind>(entry.kind),
+                                      std::string(paths + entry.pathOffset, entry.pathSize)});
+    }
+
+    for (size_t i = 0; i < header.blockCount; i++)
+    {
+        const BlockEntry& entry = table[i];
+        const SparseMatch* sparse = reinterpret_cast<const SparseMatch*>(file->data() + entry.sparseOffset);
+        ByteBuffer buffer;
+        ByteBuffer searchMask;
+
+        if (!inFile(entry.maskOffset, entry.maskSize, file->size()) || 
+            !inFile(entry.bufferOffset, entry.bufferSize, file->size()) ||
+            entry.sparseCount > file->size() / sizeof(SparseMatch) ||
+            !inFile(entry.sparseOffset, entry.sparseCount * sizeof(SparseMatch), file->size()) ||
+            entry.dataSize != static_cast<int32_t>(header.dataSize) || 
+            (entry.stride != entry.dataSize && entry.stride != 1) || 
+            (entry.maskSize > 0 && entry.bufferSize != entry.size && entry.bufferSize != 0))
+        {
+            return nullptr;
+        }
+        if (entry.maskSize > 0)
+        {
+            // dense blocks without a buffer belong to scans that don't keep previous values
+            searchMask.map(file, entry.maskOffset, entry.maskSize);
+            if (entry.bufferSize > 0)
+            {
+                buffer.map(file, entry.bufferOffset, entry.bufferSize);
+            }
+            else
+            {
+                session->hasSnapshot() = false;
+            }
+        }
+
+        Region region {reinterpret_cast<char*>(entry.addr), entry.size};
+        session->memblocks().emplace_back(pHandle, region, entry.dataSize, entry.stride, entry.matches,
+                                          std::move(buffer), std::move(searchMask),
+                                          std::vector<SparseMatch>(sparse, sparse + entry.sparseCount));
+
+        const MemBlock& mb = session->memblocks().back();
+        if (!mb.isSparse() && mb.searchMask().size() != (mb.elementCount(mb.size()) + 7) / 8)
+        {
+            return nullptr;
+        }
+    }
+
+    info.scanType = header.scanType;
+    info.encoding = header.encoding;
+    info.ignoreCase = header.flags & flagIgnoreCase;
+    info.unaligned = header.flags & flagUnaligned;
+    session->unaligned() = info.unaligned;
+    session->isScanned() = true;
+    info.value.assign(file->data() + header.valueOffset, header.valueSize);
+
+    return session;
+}
\ No newline at end of file
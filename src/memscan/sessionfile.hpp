@@ -0,0 +1,92 @@
+#pragma once
+#include "scansession.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * \brief What the Scanner needs besides the MemBlocks to continue a saved session
+ */
+struct SessionInfo
+{
+    int scanType;
+    int encoding;
+    bool ignoreCase;
+    bool unaligned;
+    // last searched value as typed, e.g. the string or byte pattern
+    std::string value;
+};
+
+/**
+ * \brief Saves scan sessions to disk and maps them back in.
+ *
+ * Layout (version 2, little endian): a FileHeader at offset 0, the BlockEntry table at the next page, the searched
+ * value, the RegionEntry table and the region paths, then per block its search mask, previous values (none for byte
+ * pattern scans) and sparse matches, each starting on a page boundary. The region table lets refreshes of a loaded
+ * session tell the regions of the scan from those mapped since. Loading checks the header and that every section lies within the file, then maps the masks and buffers
+ * straight into the MemBlocks, so sessions of any size load without reading them. Pages are only read from disk once
+ * a scan touches them.
+ */
+class SessionFile
+{
+    public:
+        static bool save(const ScanSession& session, const SessionInfo& info, const std::string& path);
+        static std::shared_ptr<ScanSession> load(const std::string& path, SessionInfo& info);
+
+        const static inline uint32_t version = 2;
+        const static inline size_t pageSize = 4096;
+
+    private:
+        struct FileHeader
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t headerSize;
+            uint64_t fileSize;
+            uint64_t processId;
+            uint32_t dataSize;
+            uint32_t scanType;
+            uint32_t encoding;
+            uint32_t flags;
+            uint64_t blockCount;
+            uint64_t tableOffset;
+            uint64_t valueOffset;
+            uint64_t valueSize;
+            uint64_t regionCount;
+            uint64_t regionOffset;
+            uint64_t pathOffset;
+            uint64_t pathSize;
+        };
+
+        struct BlockEntry
+        {
+            uint64_t addr;
+            uint64_t size;
+            uint64_t matches;
+            uint64_t maskOffset;
+            uint64_t maskSize;
+            uint64_t bufferOffset;
+            uint64_t bufferSize;
+            uint64_t sparseOffset;
+            uint64_t sparseCount;
+            int32_t dataSize;
+            int32_t stride;
+        };
+
+        /**
+         * \brief Region of the session's table, its path is pathSize bytes at pathOffset of the paths section
+         */
+        struct RegionEntry
+        {
+            uint64_t addr;
+            uint64_t size;
+            uint64_t pathOffset;
+            uint32_t pathSize;
+            uint32_t kind;
+        };
+
+        const static inline char magic[8] = {'M', 'E', 'M', 'S', 'C', 'A', 'N', 'S'};
+        const static inline uint32_t flagIgnoreCase = 1;
+        const static inline uint32_t flagUnaligned = 2;
+};
\ No newline at end of file
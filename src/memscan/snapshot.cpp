@@ -0,0 +1,117 @@
+#include "blockreader.hpp"
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+/**
+ * \brief Map a snapshot. If the file isn't a valid snapshot, isValid() is false and there are no regions.
+ */
+Snapshot::Snapshot(const std::string& path)
+    : m_file(std::make_shared<MappedFile>(path))
+    , m_processId(0)
+    , m_timestamp(0)
+{
+    FileHeader header;
+
+    if (!m_file->isValid() || m_file->size() < sizeof(header))
+    {
+        m_file.reset();
+        return;
+    }
+    std::memcpy(&header, m_file->data(), sizeof(header));
+
+    uint64_t fileSize = m_file->size();
+    auto inFile = [fileSize](uint64_t offset, uint64_t size) 
+    {
+        return offset <= fileSize && size <= fileSize - offset;
+    };
+
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version ||
+        header.headerSize != sizeof(FileHeader) || header.fileSize != fileSize ||
+        header.regionCount > fileSize / sizeof(RegionEntry) ||
+        !inFile(header.tableOffset, header.regionCount * sizeof(RegionEntry)))
+    {
+        m_file.reset();
+        return;
+    }
+
+    const RegionEntry* table = reinterpret_cast<const RegionEntry*>(m_file->data() + header.tableOffset);
+    for (size_t i = 0; i < header.regionCount; i++)
+    {
+        if (!inFile(table[i].dataOffset, table[i].size) || table[i].bytesRead > table[i].size)
+        {
+            m_regions.clear();
+            m_file.reset();
+            return;
+        }
+        m_regions.push_back({table[i].addr, table[i].size, table[i].bytesRead, m_file->data() + table[i].dataOffset});
+    }
+    m_processId = header.processId;
+    m_timestamp = header.timestamp;
+}
+
+/**
+ * \brief Write all writable regions of a process that pass filter to path. Regions are read in pieces of BlockReader::batchBytes, so
+ * memory use doesn't depend on the size of the target. Pieces that can't be read are stored as zeros.
+ * \return False if the file couldn't be written
+ */
+bool Snapshot::dump(ProcessHandle pHandle, int processId, const std::string& path, const RegionFilter& filter)
+{
+    std::vector<Region> regions = Process::writableRegions(pHandle);
+    std::vector<RegionEntry> table;
+    std::vector<char> buffer(BlockReader::batchBytes);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    FileHeader header {};
+
+    if (!out)
+    {
+        return false;
+    }
+
+    filter.apply(regions);
+    table.resize(regions.size());
+    std::sort(regions.begin(), regions.end(), [](const Region& a, const Region& b) { return a.addr < b.addr; });
+
+    // header and table are written again once the offsets are known
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    header.tableOffset = pageSize;
+    out.seekp(header.tableOffset + table.size() * sizeof(RegionEntry));
+
+    for (size_t i = 0; i < regions.size(); i++)
+    {
+        uint64_t offset = out.tellp();
+        offset = (offset + pageSize - 1) / pageSize * pageSize;
+        out.seekp(offset);
+
+        table[i] = {reinterpret_cast<uintptr_t>(regions[i].addr), regions[i].size, 0, offset};
+        for (size_t done = 0; done < regions[i].size; done += buffer.size())
+        {
+            size_t size = std::min(buffer.size(), regions[i].size - done);
+            size_t bytesRead = Process::read(pHandle, regions[i].addr + done, buffer.data(), size);
+
+            std::fill(buffer.begin() + bytesRead, buffer.begin() + size, 0);
+            table[i].bytesRead += bytesRead;
+            out.write(buffer.data(), size);
+        }
+    }
+
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.headerSize = sizeof(FileHeader);
+    header.fileSize = out.tellp();
+    header.processId = processId;
+    header.timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    header.regionCount = table.size();
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.seekp(header.tableOffset);
+    out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(RegionEntry));
+
+    return static_cast<bool>(out);
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+#include "mappedfile.hpp"
+#include "process.hpp"
+#include "regionfilter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Region of a Snapshot. data points into the mapped file, bytesRead is how much of the region could be read
+ * when the dump was taken, the rest of data is zero.
+ */
+struct SnapshotRegion
+{
+    uintptr_t addr;
+    size_t size;
+    size_t bytesRead;
+    const char* data;
+};
+
+/**
+ * \brief Copy of all writable memory of a process at one point in time, stored in a file.
+ *
+ * Layout (version 1, little endian): a FileHeader at offset 0, the RegionEntry table at the next page, then the
+ * memory of every region starting on a page boundary. Opening a snapshot maps the file, so region data is only read
+ * from disk as it is used and snapshots larger than RAM work too.
+ * \param path Snapshot file written by dump()
+ */
+class Snapshot
+{
+    public:
+        Snapshot(const std::string& path);
+
+        static bool dump(ProcessHandle pHandle, int processId, const std::string& path, 
+                         const RegionFilter& filter = RegionFilter());
+
+        bool isValid() const { return m_file && m_file->isValid(); }
+
+        const std::vector<SnapshotRegion>& regions()   const { return m_regions; }
+        const uint64_t&                    processId() const { return m_processId; }
+        const uint64_t&                    timestamp() const { return m_timestamp; }
+
+        const static inline uint32_t version = 1;
+        const static inline size_t pageSize = 4096;
+
+    private:
+        struct FileHeader
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t headerSize;
+            uint64_t fileSize;
+            uint64_t processId;
+            // seconds since the epoch
+            uint64_t timestamp;
+            uint64_t regionCount;
+            uint64_t tableOffset;
+        };
+
+        struct RegionEntry
+        {
+            uint64_t addr;
+            uint64_t size;
+            uint64_t bytesRead;
+            uint64_t dataOffset;
+        };
+
+        std::shared_ptr<MappedFile> m_file;
+        std::vector<SnapshotRegion> m_regions;
+        uint64_t m_processId;
+        uint64_t m_timestamp;
+
+        const static inline char magic[8] = {'M', 'E', 'M', 'S', 'C', 'A', 'N', 'D'};
+};
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "blockreader.hpp"
+#include "snapshotdiff.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+SnapshotDiff::SnapshotDiff(const Snapshot& before, const Snapshot& after, ThreadPool& pool)
+    : m_pool(pool)
+    , m_overlapBytes(0)
+{
+    const std::vector<SnapshotRegion>& a = before.regions();
+    const std::vector<SnapshotRegion>& b = after.regions();
+
+    // both region lists are sorted by address
+    for (size_t i = 0, j = 0; i < a.size() && j < b.size();)
+    {
+        uintptr_t begin = std::max(a[i].addr, b[j].addr);
+        uintptr_t end = std::min(a[i].addr + a[i].size, b[j].addr + b[j].size);
+
+        for (uintptr_t addr = begin; addr < end; addr += BlockReader::chunkBytes)
+        {
+            size_t size = std::min<uintptr_t>(BlockReader::chunkBytes, end - addr);
+            m_tasks.push_back({addr, size, a[i].data + (addr - a[i].addr), b[j].data + (addr - b[j].addr)});
+            m_overlapBytes += size;
+        }
+
+        if (a[i].addr + a[i].size < b[j].addr + b[j].size)
+        {
+            i++;
+        }
+        else
+        {
+            j++;
+        }
+    }
+}
+
+/**
+ * \brief Write every value that meets condition as "address before after", one per line in address order
+ * \param dataSize Size of the values, 1, 2, 4 or 8 bytes at addresses aligned to it
+ * \return Number of values written
+ */
+size_t SnapshotDiff::run(Condition condition, const Kernels::FilterArgs& args, int dataSize, std::ostream& out)
+{
+    Kernels::Filter filter = Kernels::intFilter(dataSize, condition, true);
+    size_t batchSize = m_pool.threadCount() * 2;
+    std::vector<std::string> text(batchSize);
+    std::vector<size_t> matches(batchSize);
+    size_t total = 0;
+
+    for (size_t first = 0; first < m_tasks.size(); first += batchSize)
+    {
+        size_t count = std::min(batchSize, m_tasks.size() - first);
+
+        m_pool.run(count, [&](size_t task, int)
+        {
+            text[task].clear();
+            matches[task] = runTask(m_tasks[first + task], filter, args, dataSize, text[task]);
+        });
+
+        for (size_t task = 0; task < count; task++)
+        {
+            out.write(text[task].data(), text[task].size());
+            total += matches[task];
+        }
+    }
+    out.flush();
+
+    return total;
+}
+
+size_t SnapshotDiff::runTask(const DiffTask& task, Kernels::Filter filter, const Kernels::FilterArgs& args,
+                             int dataSize, std::string& text) const
+{
+    size_t elements = task.size / dataSize;
+    // whole 32-bit mask words, the filter ANDs a word at a time
+    std::vector<char> searchMask((elements + 31) / 32 * 4, static_cast<char>(0xff));
+    char line[80];
+
+    size_t matches = 0;
+
+    if (filter(task.after, task.before, searchMask.data(), 0, elements * dataSize, args) == 0)
+    {
+        return 0;
+    }
+
+    for (size_t byte = 0; byte < searchMask.size(); byte++)
+    {
+        if (searchMask[byte] == 0)
+        {
+            continue;
+        }
+
+        for (int bit = 0; bit < 8; bit++)
+        {
+            size_t index = byte * 8 + bit;
+            if (!(searchMask[byte] & (1 << bit)) || index >= elements)
+            {
+                continue;
+            }
+
+            size_t offset = index * dataSize;
+            int size = std::snprintf(line, sizeof(line), "0x%llx %lld %lld\n",
+                                     static_cast<unsigned long long>(task.addr + offset),
+                                     static_cast<long long>(MemBlock::toInt(task.before + offset, dataSize)),
+                                     static_cast<long long>(MemBlock::toInt(task.after + offset, dataSize)));
+            text.append(line, size);
+            matches++;
+        }
+    }
+
+    return matches;
+}
\ No newline at end of file
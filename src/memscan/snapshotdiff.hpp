@@ -0,0 +1,52 @@
+#pragma once
+#include "kernels.hpp"
+#include "snapshot.hpp"
+#include "threadpool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Compares two snapshots of the same process with the integer filter kernels.
+ *
+ * The regions of both snapshots are intersected by address, and the overlaps are cut into tasks of
+ * BlockReader::chunkBytes. Every task filters its piece of the mapped files with a mask of its own, so only the pages
+ * of the tasks in flight are resident. Tasks run on the pool in batches and their output is written in address order
+ * as each batch finishes, so the diff streams at the speed of the disk whatever the size of the snapshots.
+ *
+ * Pieces of memory that couldn't be read when a snapshot was taken are zero in it and compare as such.
+ * \param before Older snapshot, the previous values of the condition
+ * \param after Newer snapshot, the current values of the condition
+ * \param pool Thread pool the tasks run on
+ */
+class SnapshotDiff
+{
+    public:
+        SnapshotDiff(const Snapshot& before, const Snapshot& after, ThreadPool& pool);
+
+        size_t run(Condition condition, const Kernels::FilterArgs& args, int dataSize, std::ostream& out);
+
+        const uint64_t& overlapBytes() const { return m_overlapBytes; }
+
+    private:
+        /**
+         * \brief Piece of an overlap of the two snapshots
+         */
+        struct DiffTask
+        {
+            uintptr_t addr;
+            size_t size;
+            const char* before;
+            const char* after;
+        };
+
+        ThreadPool& m_pool;
+        std::vector<DiffTask> m_tasks;
+        uint64_t m_overlapBytes;
+
+        size_t runTask(const DiffTask& task, Kernels::Filter filter, const Kernels::FilterArgs& args, int dataSize,
+                       std::string& text) const;
+};
\ No newline at end of file
@@ -1,78 +1,174 @@
+#include "blockreader.hpp"
+#include "kernels.hpp"
 #include "memblock.hpp"
 #include "stringscanner.hpp"
 
-#include <memoryapi.h>
-
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 
-StringScanner::StringScanner(std::vector<MemBlock> memblocks): m_pHandle(memblocks[0].pHandle()), m_memblocks(memblocks)
+namespace
+{
+    /**
+     * \brief Convert UTF-8 to UTF-16LE bytes. Invalid sequences become U+FFFD.
+     */
+    std::string utf8ToUtf16(const std::string& utf8)
+    {
+        std::string utf16;
+
+        for (size_t i = 0; i < utf8.size();)
+        {
+            unsigned char lead = utf8[i];
+            int length = (lead < 0x80) ? 1 : ((lead >> 5) == 0x6) ? 2 : ((lead >> 4) == 0xe) ? 3 : ((lead >> 3) == 0x1e) ? 4 : 0;
+            uint32_t codePoint = (length <= 1) ? lead : lead & (0x7f >> length);
+
+            if (length == 0 || i + length > utf8.size())
+            {
+                codePoint = 0xfffd;
+                length = 1;
+            }
+            for (int j = 1; j < length; j++)
+            {
+                codePoint = (codePoint << 6) | (utf8[i+j] & 0x3f);
+            }
+            i += length;
+
+            if (codePoint >= 0x10000)
+            {
+                codePoint -= 0x10000;
+                utf16 += static_cast<char>(((codePoint >> 10) + 0xd800) & 0xff);
+                utf16 += static_cast<char>(((codePoint >> 10) + 0xd800) >> 8);
+                codePoint = (codePoint & 0x3ff) + 0xdc00;
+            }
+            utf16 += static_cast<char>(codePoint & 0xff);
+            utf16 += static_cast<char>(codePoint >> 8);
+        }
+
+        return utf16;
+    }
+
+    /**
+     * \brief Convert UTF-16LE bytes to UTF-8 for printing. Unpaired surrogates become U+FFFD.
+     */
+    std::string utf16ToUtf8(const std::string& utf16)
+    {
+        std::string utf8;
+
+        for (size_t i = 0; i + 1 < utf16.size(); i += 2)
+        {
+            uint32_t codePoint = static_cast<unsigned char>(utf16[i]) | static_cast<unsigned char>(utf16[i+1]) << 8;
+
+            if (codePoint >= 0xd800 && codePoint < 0xdc00 && i + 3 < utf16.size())
+            {
+                uint32_t low = static_cast<unsigned char>(utf16[i+2]) | static_cast<unsigned char>(utf16[i+3]) << 8;
+
+                if (low >= 0xdc00 && low < 0xe000)
+                {
+                    codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+                    i += 2;
+                }
+            }
+            if (codePoint >= 0xd800 && codePoint < 0xe000)
+            {
+                codePoint = 0xfffd;
+            }
+
+            if (codePoint < 0x80)
+            {
+                utf8 += static_cast<char>(codePoint);
+            }
+            else if (codePoint < 0x800)
+            {
+                utf8 += static_cast<char>(0xc0 | codePoint >> 6);
+                utf8 += static_cast<char>(0x80 | (codePoint & 0x3f));
+            }
+            else if (codePoint < 0x10000)
+            {
+                utf8 += static_cast<char>(0xe0 | codePoint >> 12);
+                utf8 += static_cast<char>(0x80 | (codePoint >> 6 & 0x3f));
+                utf8 += static_cast<char>(0x80 | (codePoint & 0x3f));
+            }
+            else
+            {
+                utf8 += static_cast<char>(0xf0 | codePoint >> 18);
+                utf8 += static_cast<char>(0x80 | (codePoint >> 12 & 0x3f));
+                utf8 += static_cast<char>(0x80 | (codePoint >> 6 & 0x3f));
+                utf8 += static_cast<char>(0x80 | (codePoint & 0x3f));
+            }
+        }
+
+        return utf8;
+    }
+}
+
+StringScanner::StringScanner(std::shared_ptr<ScanSession> session, ThreadPool& pool, StringEncoding encoding, 
+                             bool ignoreCase)
+    : m_session(session)
+    , m_pool(pool)
+    , m_encoding(encoding)
+    , m_ignoreCase(ignoreCase)
 {}
 
-StringScanner::~StringScanner()
+/**
+ * \brief Convert a typed value to the bytes searched in the target: UTF-16LE for wide strings, with ASCII letters in
+ * lower case when case is ignored
+ */
+std::string StringScanner::encode(const std::string& val) const
 {
-    CloseHandle(m_pHandle);
+    std::string encoded = (m_encoding == ENC_UTF16LE) ? utf8ToUtf16(val) : val;
+    size_t step = (m_encoding == ENC_UTF16LE) ? 2 : 1;
+
+    if (m_ignoreCase)
+    {
+        for (size_t i = 0; i < encoded.size(); i += step)
+        {
+            if (encoded[i] >= 'A' && encoded[i] <= 'Z' && (step == 1 || encoded[i+1] == 0))
+            {
+                encoded[i] |= 0x20;
+            }
+        }
+    }
+
+    return encoded;
 }
 
-void StringScanner::updateSearch(MemBlock& mb, 
-                                 int bytesRead, 
-                                 std::string& tempBuf, 
-                                 Condition condition, 
-                                 std::string val)
+/**
+ * \brief Filter the strings starting in one chunk. They may reach past the end of the chunk, up to its limit. Equality
+ * runs the string kernel, increased and decreased compare the strings in place.
+ * \return Number of matches in chunk
+ */
+size_t StringScanner::updateSearch(MemBlock& mb, const ScanChunk& chunk, Condition condition, const std::string& val)
 {
-    for (int offset = 0; offset < bytesRead; offset++) 
+    size_t matches = 0;
+    const char* tempBuf = chunk.data - chunk.begin;
+    size_t bytesRead = chunk.limit;
+
+    if (condition == COND_EQUALS)
+    {
+        // an empty value compares its terminating zero, like before the kernel existed
+        Kernels::StringFilter filter = Kernels::stringFilter(m_encoding, m_ignoreCase);
+
+        return filter(chunk.data, mb.searchMask().data(), chunk.begin, chunk.end, chunk.limit, val.c_str(),
+                      std::max<size_t>(val.size(), 1));
+    }
+
+    for (size_t offset = chunk.begin; offset < chunk.end; offset++) 
     {
         if (mb.isInSearch(offset))
         {
-            std::string strBuffer;
-            std::string prevStr;
             bool isMatch = false;
 
-            strBuffer.resize(val.size());
-
-            switch (condition) 
+            if ((m_encoding != ENC_UTF16LE || offset % 2 == 0) && offset + val.size() <= bytesRead 
+                && tempBuf[offset] == mb.buffer()[offset])
             {
-                case COND_EQUALS:
-                    if (tempBuf[offset] == val[0])
-                    {
-                        for (int i = 0; i < val.size(); i++)
-                        {
-                            strBuffer[i] = tempBuf[offset+i];
-                        }
-                        isMatch = (strBuffer.compare(val) == 0) ? true : false;
-                    }
-                    break;
-                case COND_INCREASED:
-                    if (tempBuf[offset] == mb.buffer()[offset])
-                    {
-                        prevStr.resize(val.size());
-                        for (int i = 0; i < strBuffer.size(); i++)
-                        {
-                            prevStr[i] = mb.buffer()[offset+i];
-                            strBuffer[i] = tempBuf[offset+i];
-                        }
-                        isMatch = (prevStr.compare(strBuffer) > 0) ? true : false;
-                    }
-                    break;
-                case COND_DECREASED:
-                    if (tempBuf[offset] == mb.buffer()[offset])
-                    {
-                        prevStr.resize(val.size());
-                        for (int i = 0; i < strBuffer.size(); i++)
-                        {
-                            prevStr[i] = mb.buffer()[offset+i];
-                            strBuffer[i] = tempBuf[offset+i];
-                        }
-                        isMatch = (prevStr.compare(strBuffer) < 0) ? true : false;
-                    }
-                    break;
-                default:
-                    break;
+                int cmp = std::memcmp(mb.buffer().data() + offset, tempBuf + offset, val.size());
+
+                isMatch = (condition == COND_INCREASED) ? (cmp > 0) : (condition == COND_DECREASED) && (cmp < 0);
             }
 
             if (isMatch) 
             {
-                mb.matches() = mb.matches()+1;
+                matches++;
             } 
             else
             {
@@ -80,63 +176,103 @@ void StringScanner::updateSearch(MemBlock& mb,
             }
         }
     }
+
+    return matches;
 }
 
-void StringScanner::updateMemBlock(MemBlock& mb, Condition condition, std::string val)
+/**
+ * \brief Filter one chunk of a block
+ * \return Number of matches in chunk
+ */
+size_t StringScanner::updateChunk(MemBlock& mb, const ScanChunk& chunk, Condition condition, const std::string& val)
 {
-    std::string tempBuf;
-    int bytesToRead;
-    SIZE_T bytesRead;
+    if (condition == COND_UNCONDITIONAL) 
+    {
+        mb.fillSearch(chunk.begin, chunk.end, true);
+        return chunk.end - chunk.begin;
+    } 
 
-    tempBuf.resize(mb.size());
+    return updateSearch(mb, chunk, condition, val);
+}
 
-    if (mb.size() > 0) 
+/**
+ * \brief Read the live pages of all blocks batch by batch and filter each batch in parallel. Strings reach past the 
+ * end of a chunk, so previous values are only replaced after the whole batch has been filtered. Blocks without 
+ * matches are dropped at the end.
+ */
+void StringScanner::updateScan(Condition condition, std::string val) 
+{
+    val = encode(val);
+    BlockReader reader(pHandle(), memblocks(), val.empty() ? 0 : val.size() - 1);
+
+    for (auto& mb : memblocks())
     {
         mb.matches() = 0;
+    }
+
+    while (reader.next())
+    {
+        std::vector<ScanChunk> chunks = reader.chunks();
+        std::vector<std::vector<size_t>> workerMatches(m_pool.threadCount(), 
+                                                       std::vector<size_t>(reader.blocks().size(), 0));
 
-        bytesToRead = mb.size();
-        ReadProcessMemory(m_pHandle, mb.addr(), &tempBuf[0], bytesToRead, &bytesRead);
-        if (condition == COND_UNCONDITIONAL) 
+        m_pool.run(chunks.size(), [&](size_t task, int worker)
         {
-            std::fill(mb.searchMask().begin(), mb.searchMask().begin()+bytesRead/8, 0xff);
-            mb.matches() += bytesRead;
-        } 
-        else
+            const ScanChunk& chunk = chunks[task];
+            workerMatches[worker][chunk.block] += updateChunk(*reader.blocks()[chunk.block], chunk, condition, val);
+        });
+        m_pool.run(chunks.size(), [&](size_t task, int) { reader.store(chunks[task]); });
+
+        for (size_t i = 0; i < reader.blocks().size(); i++)
         {
-            updateSearch(mb, bytesRead, tempBuf, condition, val);
+            for (auto& matches : workerMatches)
+            {
+                reader.blocks()[i]->matches() += matches[i];
+            }
         }
-
-        std::memcpy(mb.buffer().data(), &tempBuf[0], bytesRead);
-        mb.size() = bytesRead;
     }
+
+    MemBlock::removeDead(memblocks());
+    m_session->isScanned() = true;
 }
 
-void StringScanner::updateScan(Condition condition, std::string val) 
+/**
+ * \brief Write a typed value in the scan's encoding
+ */
+void StringScanner::writeString(uintptr_t addr, std::string val)
 {
-    for (auto& mb : m_memblocks)
+    if (m_encoding == ENC_UTF16LE)
     {
-        updateMemBlock(mb, condition, val);
+        val = utf8ToUtf16(val);
     }
-}
 
-void StringScanner::writeString(uintptr_t addr, std::string val)
-{
     int size = val.size();
-    if (!WriteProcessMemory(m_pHandle, reinterpret_cast<uintptr_t*>(addr), &val[0], size, nullptr))
+    if (!Process::write(pHandle(), addr, &val[0], size))
     {
         std::cout << "writing failed\r\n";
     }
 }
 
+/**
+ * \brief Read size bytes of a string and convert them to UTF-8
+ */
 std::string StringScanner::readString(uintptr_t addr, int size)
 {
     std::string strBuffer;
     strBuffer.resize(size);
 
-    if (!ReadProcessMemory(m_pHandle, reinterpret_cast<uintptr_t*>(addr), &strBuffer[0], size, nullptr))
+    if (Process::read(pHandle(), reinterpret_cast<void*>(addr), &strBuffer[0], size) != static_cast<size_t>(size))
     {
         std::cout << "reading failed\r\n";
     }
 
-    return strBuffer;
+    return decode(strBuffer);
+}
+
+/**
+ * \brief Turn bytes as found in memory into UTF-8
+ */
+std::string StringScanner::decode(const std::string& raw) const
+{
+    return (m_encoding == ENC_UTF16LE) ? utf16ToUtf8(raw) : raw;
 }
\ No newline at end of file
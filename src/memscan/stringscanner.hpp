@@ -1,31 +1,44 @@
 #pragma once
+#include "blockreader.hpp"
+#include "kernels.hpp"
 #include "memblock.hpp"
+#include "process.hpp"
+#include "scansession.hpp"
+#include "threadpool.hpp"
 
+#include <memory>
 #include <string>
 
 /**
- * \brief String value scanner
- * \param memblocks Vector of MemBlocks
+ * \brief String value scanner. Values are typed as UTF-8 and searched in the target's encoding.
+ * \param session Scan session, shared with the Scanner
+ * \param pool Thread pool used for filtering
+ * \param encoding Encoding of the strings in the target
+ * \param ignoreCase True if ASCII letters match regardless of case
  */
 class StringScanner
 {
     public:
-        StringScanner(std::vector<MemBlock> memblocks);
-        ~StringScanner();
+        StringScanner(std::shared_ptr<ScanSession> session, ThreadPool& pool, StringEncoding encoding, bool ignoreCase);
 
         void updateScan(Condition condition, std::string val);
         void writeString(uintptr_t addr, std::string val);
         std::string readString(uintptr_t addr, int size);
+        std::string encode(const std::string& val) const;
+        std::string decode(const std::string& raw) const;
 
-              HANDLE&                pHandle()         { return m_pHandle; }
-        const HANDLE&                pHandle()   const { return m_pHandle; }
-              std::vector<MemBlock>& memblocks()       { return m_memblocks; }
-        const std::vector<MemBlock>& memblocks() const { return m_memblocks; }
+        const ProcessHandle&         pHandle()    const { return m_session->pHandle(); }
+              std::vector<MemBlock>& memblocks()        { return m_session->memblocks(); }
+        const std::vector<MemBlock>& memblocks()  const { return m_session->memblocks(); }
+        const StringEncoding&        encoding()   const { return m_encoding; }
+        const bool&                  ignoreCase() const { return m_ignoreCase; }
 
     private:
-        HANDLE m_pHandle;
-        std::vector<MemBlock> m_memblocks;
+        std::shared_ptr<ScanSession> m_session;
+        ThreadPool& m_pool;
+        StringEncoding m_encoding;
+        bool m_ignoreCase;
         
-        void updateSearch(MemBlock& mb, int bytesRead, std::string& tempBuf, Condition condition, std::string val);
-        void updateMemBlock(MemBlock& mb, Condition condition, std::string val);
+        size_t updateSearch(MemBlock& mb, const ScanChunk& chunk, Condition condition, const std::string& val);
+        size_t updateChunk(MemBlock& mb, const ScanChunk& chunk, Condition condition, const std::string& val);
 };
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "kernels.hpp"
+#include "memblock.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief Checks that the SSE4.2 and AVX2 filter kernels leave the same search mask and match count as the scalar
+ * ones, for every condition, data size and both alignments. Chunks start at a mask word and end with a tail that
+ * doesn't fill one, so the hand over to the scalar kernel is checked as well. Instruction sets the CPU lacks are
+ * skipped.
+ * \return 0 if all kernels agree
+ */
+
+namespace
+{
+    const Condition intConditions[] = {COND_EQUALS, COND_INCREASED, COND_DECREASED, COND_CHANGED, COND_UNCHANGED,
+                                       COND_BETWEEN, COND_INCREASED_BY, COND_DECREASED_BY, COND_BITMASK};
+    const Condition floatConditions[] = {COND_EQUALS, COND_INCREASED, COND_DECREASED, COND_CHANGED, COND_UNCHANGED,
+                                         COND_BETWEEN};
+    const char* isaNames[] = {"scalar", "sse4.2", "avx2"};
+
+    /**
+     * \brief New and previous values of a chunk and its search mask before filtering
+     */
+    struct Chunk
+    {
+        std::vector<char> current;
+        std::vector<char> previous;
+        std::vector<char> searchMask;
+        size_t begin;
+        size_t end;
+    };
+
+    void storeFloat(char* dest, double val, int dataSize)
+    {
+        float valFloat = static_cast<float>(val);
+
+        if (dataSize == 4)
+        {
+            std::memcpy(dest, &valFloat, sizeof(valFloat));
+        }
+        else
+        {
+            std::memcpy(dest, &val, sizeof(val));
+        }
+    }
+
+    /**
+     * \brief Random chunk with few distinct values, so that every condition keeps some elements and drops others.
+     * Floats are multiples of 0.25 and compare exactly.
+     */
+    Chunk makeChunk(std::mt19937_64& rng, int dataSize, bool isFloat, bool aligned)
+    {
+        size_t stride = aligned ? dataSize : 1;
+        Chunk chunk;
+
+        chunk.begin = 32 * stride * (rng() % 3);
+        chunk.end = 4096 + rng() % 300;
+        chunk.current.resize(chunk.end);
+        chunk.previous.resize(chunk.end);
+        for (size_t i = 0; i < chunk.end; i++)
+        {
+            chunk.current[i] = rng() % 2;
+            chunk.previous[i] = rng() % 2;
+        }
+        for (size_t i = 0; isFloat && i + dataSize <= chunk.end; i += dataSize)
+        {
+            double current = (rng() % 8) * 0.25;
+
+            storeFloat(&chunk.current[i], current, dataSize);
+            storeFloat(&chunk.previous[i], rng() % 2 ? current : (rng() % 8) * 0.25, dataSize);
+        }
+
+        chunk.searchMask.resize(((chunk.end - dataSize) / stride + 1 + 7) / 8);
+        for (auto& byte : chunk.searchMask)
+        {
+            // most elements start in search
+            byte = static_cast<char>(rng() | rng());
+        }
+
+        return chunk;
+    }
+
+    /**
+     * \brief Operands that match some elements of the chunk, taken from its values at the begin of the chunk
+     */
+    Kernels::FilterArgs makeArgs(std::mt19937_64& rng, const Chunk& chunk, int dataSize, Condition condition)
+    {
+        Kernels::FilterArgs args = {0, 0, 0.5, 1.25};
+        int64_t current = MemBlock::toInt(&chunk.current[chunk.begin], dataSize);
+        int64_t previous = MemBlock::toInt(&chunk.previous[chunk.begin], dataSize);
+
+        switch (condition)
+        {
+            case COND_EQUALS:
+                args.val = current;
+                break;
+            case COND_BETWEEN:
+                // includes unbounded and empty ranges
+                args.val = rng() % 4 == 0 ? INT64_MIN : current - static_cast<int64_t>(rng() % 300);
+                args.val2 = rng() % 4 == 0 ? INT64_MAX : current + static_cast<int64_t>(rng() % 70000);
+                if (rng() % 10 == 0)
+                {
+                    std::swap(args.val, args.val2);
+                }
+                break;
+            case COND_INCREASED_BY:
+                args.val = current - previous;
+                break;
+            case COND_DECREASED_BY:
+                args.val = previous - current;
+                break;
+            case COND_BITMASK:
+                args.val2 = static_cast<int64_t>(rng() & 0x0101010101010101);
+                args.val = current & args.val2;
+                break;
+            default:
+                break;
+        }
+
+        return args;
+    }
+
+    /**
+     * \brief Filter copies of the chunk with the kernels of every instruction set up to best
+     * \return Number of instruction sets whose mask or count differs from the scalar kernel
+     */
+    int compareKernels(const Chunk& chunk, int dataSize, bool isFloat, bool aligned, Condition condition,
+                       const Kernels::FilterArgs& args, InstructionSet best)
+    {
+        std::vector<char> expectedMask;
+        size_t expectedCount = 0;
+        int failures = 0;
+
+        for (int isa = ISA_SCALAR; isa <= best; isa++)
+        {
+            Kernels::limitInstructionSet(static_cast<InstructionSet>(isa));
+
+            Kernels::Filter filter = isFloat ? Kernels::floatFilter(dataSize, condition, aligned)
+                                             : Kernels::intFilter(dataSize, condition, aligned);
+            std::vector<char> searchMask = chunk.searchMask;
+            size_t count = filter(chunk.current.data() + chunk.begin, chunk.previous.data() + chunk.begin,
+                                  searchMask.data(), chunk.begin, chunk.end, args);
+
+            if (isa == ISA_SCALAR)
+            {
+                expectedMask.swap(searchMask);
+                expectedCount = count;
+            }
+            else if (searchMask != expectedMask || count != expectedCount)
+            {
+                std::printf("%s %s%d %s condition %d, bytes %zu-%zu: %zu matches, scalar %zu\n", isaNames[isa],
+                            isFloat ? "float" : "int", dataSize * 8, aligned ? "aligned" : "unaligned", condition,
+                            chunk.begin, chunk.end, count, expectedCount);
+                failures++;
+            }
+        }
+
+        return failures;
+    }
+}
+
+int main()
+{
+    InstructionSet best = Kernels::instructionSet();
+    std::mt19937_64 rng(1);
+    int checks = 0;
+    int failures = 0;
+
+    for (int round = 0; round < 50; round++)
+    {
+        for (int dataSize : {1, 2, 4, 8})
+        {
+            for (bool aligned : {true, false})
+            {
+                for (Condition condition : intConditions)
+                {
+                    Chunk chunk = makeChunk(rng, dataSize, false, aligned);
+                    Kernels::FilterArgs args = makeArgs(rng, chunk, dataSize, condition);
+
+                    failures += compareKernels(chunk, dataSize, false, aligned, condition, args, best);
+                    checks++;
+                }
+                for (Condition condition : floatConditions)
+                {
+                    if (dataSize < 4)
+                    {
+                        break;
+                    }
+
+                    Chunk chunk = makeChunk(rng, dataSize, true, aligned);
+                    Kernels::FilterArgs args = makeArgs(rng, chunk, dataSize, condition);
+
+                    failures += compareKernels(chunk, dataSize, true, aligned, condition, args, best);
+                    checks++;
+                }
+            }
+        }
+    }
+
+    std::printf("%d chunks up to %s, %d failures\n", checks, isaNames[best], failures);
+    return failures > 0 ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "intscanner.hpp"
+#include "matchpage.hpp"
+#include "regionfilter.hpp"
+#include "scanner.hpp"
+#include "sessionfile.hpp"
+#include "threadpool.hpp"
+
+#ifdef _WIN32
+#include <processthreadsapi.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Scans memory of this process, saves the session, loads it back and checks that the loaded session has the
+ * same matches, regions and previous values as the original: both filter to the same matches after the values
+ * changed, and refreshing the loaded session keeps all of its blocks. One array keeps few matches (sparse blocks),
+ * the other many (dense blocks).
+ * \return 0 if every check passed
+ */
+
+namespace
+{
+    const int32_t magic = 123456789;
+    // large enough for allocations of their own, the region filter limits the scan to them
+    const size_t valueCount = 1 << 20;
+
+    int failures = 0;
+
+    void check(bool passed, const char* what)
+    {
+        if (!passed)
+        {
+            std::printf("failed: %s\n", what);
+            failures++;
+        }
+    }
+
+    int currentProcessId()
+    {
+#ifdef _WIN32
+        return static_cast<int>(GetCurrentProcessId());
+#else
+        return static_cast<int>(getpid());
+#endif
+    }
+
+    std::string rangeTerm(const std::vector<int32_t>& values)
+    {
+        char term[64];
+
+        std::snprintf(term, sizeof(term), "range:%#llx-%#llx",
+                      static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(values.data())),
+                      static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(values.data() + values.size())));
+        return term;
+    }
+
+    size_t countMagic(const std::vector<int32_t>& values)
+    {
+        size_t count = 0;
+
+        for (int32_t val : values)
+        {
+            count += val == magic;
+        }
+
+        return count;
+    }
+
+    bool hasBlocks(const ScanSession& session, bool isSparse)
+    {
+        for (auto& mb : session.memblocks())
+        {
+            if (mb.isSparse() == isSparse && mb.matches() > 0)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    std::vector<uintptr_t> matchAddresses(const ScanSession& session)
+    {
+        MatchPage page(session.pHandle(), session.memblocks(), 0, 0, session.dataSize(), session.hasSnapshot());
+        std::vector<uintptr_t> addresses;
+
+        for (auto& entry : page.entries())
+        {
+            addresses.push_back(entry.addr);
+        }
+
+        return addresses;
+    }
+
+    bool sameRegions(const std::vector<Region>& a, const std::vector<Region>& b)
+    {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            if (a[i].addr != b[i].addr || a[i].size != b[i].size || a[i].kind != b[i].kind || a[i].path != b[i].path)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+int main()
+{
+    ThreadPool pool(0);
+    std::vector<int32_t> sparse(valueCount);
+    std::vector<int32_t> dense(valueCount);
+    std::string path = "sessionfiletest.mss";
+    std::string error;
+    RegionFilter filter;
+
+    for (size_t i = 0; i < valueCount; i++)
+    {
+        sparse[i] = i % 997 == 0 ? magic : static_cast<int32_t>(i);
+        dense[i] = i % 2 == 0 ? magic : static_cast<int32_t>(i);
+    }
+    if (!filter.parse(rangeTerm(sparse) + " " + rangeTerm(dense), error))
+    {
+        std::printf("failed: region filter %s\n", error.c_str());
+        return 1;
+    }
+
+    std::shared_ptr<ScanSession> session = ScanSession::open(currentProcessId(), 4, false, filter);
+    if (!session)
+    {
+        std::printf("failed: can't open this process\n");
+        return 1;
+    }
+    IntScanner(session, pool).updateScan(COND_EQUALS, magic);
+    check(session->matches() == countMagic(sparse) + countMagic(dense), "matches of the first scan");
+    check(hasBlocks(*session, true) && hasBlocks(*session, false), "sparse and dense blocks");
+
+    SessionInfo info {SCAN_INT, ENC_UTF8, false, false, std::to_string(magic)};
+    check(SessionFile::save(*session, info, path), "save");
+
+    // every third match changes, both sessions have to drop the same ones
+    for (size_t i = 0; i < valueCount; i += 3)
+    {
+        sparse[i] = sparse[i] == magic ? magic + 1 : sparse[i];
+        dense[i] = dense[i] == magic ? magic + 1 : dense[i];
+    }
+
+    SessionInfo loadedInfo;
+    std::shared_ptr<ScanSession> loaded = SessionFile::load(path, loadedInfo);
+    if (!loaded)
+    {
+        std::printf("failed: load\n");
+        std::remove(path.c_str());
+        return 1;
+    }
+    check(loadedInfo.scanType == SCAN_INT && loadedInfo.value == info.value, "session info");
+    check(loaded->dataSize() == 4 && loaded->isScanned(), "loaded session state");
+    check(sameRegions(loaded->regions(), session->regions()), "region table");
+    check(matchAddresses(*loaded) == matchAddresses(*session), "matches after loading");
+
+    IntScanner(session, pool).updateScan(COND_UNCHANGED, 0);
+    IntScanner(loaded, pool).updateScan(COND_UNCHANGED, 0);
+    check(loaded->matches() == countMagic(sparse) + countMagic(dense), "matches after filtering the loaded session");
+    check(matchAddresses(*loaded) == matchAddresses(*session), "matches after filtering both sessions");
+
+    size_t blocks = loaded->memblocks().size();
+    loaded->regionFilter() = filter;
+    RegionRefresh refresh = loaded->refreshRegions(pool);
+    check(refresh.keptBlocks == blocks && refresh.addedRegions == 0 && refresh.retiredBlocks == 0,
+          "refresh of the loaded session");
+
+    // the loaded session maps the file, replacing it must not disturb it
+    check(SessionFile::save(*loaded, loadedInfo, path), "save over the loaded file");
+    check(matchAddresses(*loaded) == matchAddresses(*session), "matches after saving over the loaded file");
+
+    loaded.reset();
+    std::remove(path.c_str());
+
+    std::printf("%d failures\n", failures);
+    return failures > 0 ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "threadpool.hpp"
+
+ThreadPool::ThreadPool(int threadCount)
+    : m_threadCount(threadCount > 0 ? threadCount : hardwareThreads())
+    , m_task(nullptr)
+    , m_generation(0)
+    , m_finished(0)
+    , m_stop(false)
+{
+    for (int i = 0; i < m_threadCount; i++)
+    {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (int i = 0; i < m_threadCount-1; i++)
+    {
+        m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+int ThreadPool::hardwareThreads()
+{
+    int count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+/**
+ * \brief Run task(0..taskCount-1) on all workers and wait until every task has finished. If another thread's call
+ * has the workers, the tasks run on the calling thread in order until that call is done.
+ * \param taskCount Number of tasks
+ * \param task Called once per task index, with the index of the worker running it. Tasks of concurrent calls may see
+ * the same worker index at the same time, per worker state belongs to the call.
+ */
+void ThreadPool::run(size_t taskCount, const Task& task)
+{
+    std::unique_lock<std::mutex> running(m_runMutex, std::try_to_lock);
+    size_t next = 0;
+
+    while (!running.owns_lock() && next < taskCount)
+    {
+        task(next++, m_threadCount-1);
+        running.try_lock();
+    }
+    if (next == taskCount)
+    {
+        return;
+    }
+
+    size_t remaining = taskCount - next;
+    for (int i = 0; i < m_threadCount; i++)
+    {
+        size_t first = next + remaining * i / m_threadCount;
+        size_t last = next + remaining * (i+1) / m_threadCount;
+
+        std::lock_guard<std::mutex> lock(m_queues[i]->mutex);
+        for (size_t t = first; t < last; t++)
+        {
+            m_queues[i]->tasks.push_back(t);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_finished = 0;
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    drain(m_threadCount-1);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_finished == m_threadCount-1; });
+    m_task = nullptr;
+}
+
+void ThreadPool::workerLoop(int worker)
+{
+    size_t generation = 0;
+
+    while (1)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != generation; });
+            if (m_stop)
+            {
+                return;
+            }
+            generation = m_generation;
+        }
+
+        drain(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_finished++;
+        }
+        m_done.notify_one();
+    }
+}
+
+void ThreadPool::drain(int worker)
+{
+    size_t task;
+
+    while (popTask(worker, task))
+    {
+        (*m_task)(task, worker);
+    }
+}
+
+/**
+ * \brief Take the newest task of own queue, or steal the oldest task of another worker
+ * \return False if all queues are empty
+ */
+bool ThreadPool::popTask(int worker, size_t& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queues[worker]->mutex);
+        if (!m_queues[worker]->tasks.empty())
+        {
+            task = m_queues[worker]->tasks.back();
+            m_queues[worker]->tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (int i = 1; i < m_threadCount; i++)
+    {
+        WorkQueue& victim = *m_queues[(worker+i) % m_threadCount];
+
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Work-stealing thread pool.
+ *
+ * Every worker owns a task queue. run() deals the tasks out in contiguous ranges, workers pop from the back of their
+ * own queue and steal from the front of the others once theirs is empty. The calling thread acts as the last worker,
+ * so a pool of 1 thread runs everything inline. run() may be called from several threads at once: while the workers
+ * are busy with another call, a caller runs its tasks itself and hands the rest over once they are free.
+ * \param threadCount Number of workers including the calling thread. Values below 1 use all hardware threads.
+ */
+class ThreadPool
+{
+    public:
+        typedef std::function<void(size_t task, int worker)> Task;
+
+        ThreadPool(int threadCount);
+        ~ThreadPool();
+
+        void run(size_t taskCount, const Task& task);
+
+        int threadCount() const { return m_threadCount; }
+
+        static int hardwareThreads();
+
+    private:
+        struct WorkQueue
+        {
+            std::mutex mutex;
+            std::deque<size_t> tasks;
+        };
+
+        int m_threadCount;
+        std::vector<std::thread> m_threads;
+        std::vector<std::unique_ptr<WorkQueue>> m_queues;
+        // held by the call the workers are running
+        std::mutex m_runMutex;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        const Task* m_task;
+        size_t m_generation;
+        int m_finished;
+        bool m_stop;
+
+        void workerLoop(int worker);
+        void drain(int worker);
+        bool popTask(int worker, size_t& task);
+};
\ No newline at end of file
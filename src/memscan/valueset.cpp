@@ -0,0 +1,40 @@
+#include "valueset.hpp"
+
+#include <algorithm>
+
+ValueSet::ValueSet(const std::vector<int64_t>& values, int dataSize)
+    : m_shift(64)
+{
+    int bits = 4;
+
+    for (auto val : values)
+    {
+        int shift = 64 - 8*dataSize;
+
+        if ((static_cast<int64_t>(static_cast<uint64_t>(val) << shift) >> shift) == val)
+        {
+            m_values.push_back(val);
+        }
+    }
+    std::sort(m_values.begin(), m_values.end());
+    m_values.erase(std::unique(m_values.begin(), m_values.end()), m_values.end());
+
+    // at most a quarter of the slots are taken, so that lookups of missing values mostly hit an empty slot at once
+    while ((size_t(1) << bits) < 4 * m_values.size())
+    {
+        bits++;
+    }
+    m_shift = 64 - bits;
+    m_slots.assign(size_t(1) << bits, 0);
+
+    for (size_t i = 0; i < m_values.size(); i++)
+    {
+        size_t slot = hash(m_values[i]);
+
+        while (m_slots[slot] != 0)
+        {
+            slot = (slot + 1) & (m_slots.size() - 1);
+        }
+        m_slots[slot] = i + 1;
+    }
+}
\ No newline at end of file
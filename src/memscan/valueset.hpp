@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * \brief Set of integer values searched in one pass. Values are kept sorted, so that the bounds give a range that
+ * SIMD kernels reject most memory with, and hashed into an open addressing table a few times larger than the set for
+ * the exact lookup of what is left.
+ * \param values Values to search for, values that don't fit dataSize are left out
+ * \param dataSize Size of the searched integers
+ */
+class ValueSet
+{
+    public:
+        ValueSet(const std::vector<int64_t>& values, int dataSize);
+
+        /**
+         * \brief Index of val in values(), or -1 if it isn't in the set
+         */
+        int find(int64_t val) const
+        {
+            for (size_t slot = hash(val); m_slots[slot] != 0; slot = (slot + 1) & (m_slots.size() - 1))
+            {
+                if (m_values[m_slots[slot]-1] == val)
+                {
+                    return m_slots[slot] - 1;
+                }
+            }
+
+            return -1;
+        }
+
+        bool empty() const { return m_values.empty(); }
+
+        const std::vector<int64_t>& values() const { return m_values; }
+        const int64_t&              min()    const { return m_values.front(); }
+        const int64_t&              max()    const { return m_values.back(); }
+
+    private:
+        std::vector<int64_t> m_values;
+        std::vector<uint32_t> m_slots;
+        int m_shift;
+
+        size_t hash(int64_t val) const
+        {
+            return (static_cast<uint64_t>(val) * 0x9e3779b97f4a7c15ull) >> m_shift;
+        }
+};
\ No newline at end of file
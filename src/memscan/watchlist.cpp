@@ -0,0 +1,204 @@
+#include "memblock.hpp"
+#include "watchlist.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+WatchList::WatchList(std::shared_ptr<ScanSession> session, const std::vector<uintptr_t>& addrs, bool isFloat,
+                     size_t historySize)
+    : m_session(session)
+    , m_addrs(addrs)
+    , m_isFloat(isFloat)
+    , m_historySize(std::max<size_t>(historySize, 1))
+    , m_sampleCount(0)
+    , m_stop(false)
+{
+    std::sort(m_addrs.begin(), m_addrs.end());
+    m_addrs.erase(std::unique(m_addrs.begin(), m_addrs.end()), m_addrs.end());
+
+    m_history.resize(m_historySize * m_addrs.size());
+    for (auto addr : m_addrs)
+    {
+        m_stats.push_back({addr, 0, 0, 0, 0, 0});
+    }
+    buildSpans();
+}
+
+WatchList::~WatchList()
+{
+    stop();
+}
+
+/**
+ * \brief Group the sorted addresses into one read per page. A value that crosses a page boundary extends the span of
+ * its first page.
+ */
+void WatchList::buildSpans()
+{
+    size_t dataSize = m_session->dataSize();
+    size_t currentSize = 0;
+
+    for (auto addr : m_addrs)
+    {
+        bool samePage = !m_spans.empty() &&
+            addr / pageSize == (reinterpret_cast<uintptr_t>(m_spans.back().addr) + m_spans.back().size - 1) / pageSize;
+
+        if (!samePage)
+        {
+            m_spans.push_back({reinterpret_cast<char*>(addr), nullptr, 0, 0});
+        }
+
+        size_t spanOffset = addr - reinterpret_cast<uintptr_t>(m_spans.back().addr);
+        size_t size = std::max(m_spans.back().size, spanOffset + dataSize);
+
+        m_offsets.push_back(currentSize - m_spans.back().size + spanOffset);
+        currentSize += size - m_spans.back().size;
+        m_spans.back().size = size;
+    }
+
+    // m_current is complete, so it doesn't move anymore
+    m_current.resize(currentSize);
+    for (size_t i = 0, offset = 0; i < m_spans.size(); i++)
+    {
+        m_spans[i].buffer = m_current.data() + offset;
+        offset += m_spans[i].size;
+    }
+}
+
+/**
+ * \brief Start sampling every interval. Does nothing if sampling is already running.
+ */
+void WatchList::start(std::chrono::microseconds interval)
+{
+    if (m_thread.joinable())
+    {
+        return;
+    }
+
+    m_stop = false;
+    m_thread = std::thread(&WatchList::sampleLoop, this, interval);
+}
+
+void WatchList::stop()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+}
+
+std::vector<WatchStats> WatchList::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+/**
+ * \brief Samples of the address at index that are still in the ring buffer, oldest first
+ */
+std::vector<int64_t> WatchList::history(size_t index) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<int64_t> samples;
+    size_t count = std::min(m_sampleCount, m_historySize);
+
+    for (size_t i = m_sampleCount - count; i < m_sampleCount; i++)
+    {
+        samples.push_back(m_history[(i % m_historySize) * m_addrs.size() + index]);
+    }
+
+    return samples;
+}
+
+double WatchList::asDouble(int64_t value) const
+{
+    if (!m_isFloat)
+    {
+        return static_cast<double>(value);
+    }
+    if (m_session->dataSize() == 8)
+    {
+        double val;
+        std::memcpy(&val, &value, sizeof(val));
+        return val;
+    }
+
+    float val;
+    int32_t bits = static_cast<int32_t>(value);
+    std::memcpy(&val, &bits, sizeof(val));
+    return val;
+}
+
+bool WatchList::less(int64_t a, int64_t b) const
+{
+    return m_isFloat ? asDouble(a) < asDouble(b) : a < b;
+}
+
+/**
+ * \brief Store the values just read as the next row of the ring buffer and update the stats. Addresses whose page
+ * couldn't be read are skipped.
+ */
+void WatchList::addSample()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int64_t* row = m_history.data() + (m_sampleCount % m_historySize) * m_addrs.size();
+    int dataSize = m_session->dataSize();
+    size_t span = 0;
+
+    for (size_t i = 0; i < m_addrs.size(); i++)
+    {
+        WatchStats& stats = m_stats[i];
+
+        while (reinterpret_cast<uintptr_t>(m_spans[span].addr) + m_spans[span].size < m_addrs[i] + dataSize)
+        {
+            span++;
+        }
+        if (m_spans[span].bytesRead != m_spans[span].size)
+        {
+            row[i] = stats.last;
+            continue;
+        }
+
+        int64_t value = MemBlock::toInt(m_current.data() + m_offsets[i], dataSize);
+        row[i] = value;
+        if (stats.samples == 0)
+        {
+            stats.min = value;
+            stats.max = value;
+        }
+        else if (value != stats.last)
+        {
+            stats.changes++;
+            stats.min = less(value, stats.min) ? value : stats.min;
+            stats.max = less(stats.max, value) ? value : stats.max;
+        }
+        stats.last = value;
+        stats.samples++;
+    }
+    m_sampleCount++;
+}
+
+void WatchList::sampleLoop(std::chrono::microseconds interval)
+{
+    auto nextTick = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_stop)
+    {
+        lock.unlock();
+        Process::readBatch(m_session->pHandle(), m_spans);
+        addSample();
+        lock.lock();
+
+        // missed ticks are skipped, not sampled in a burst
+        nextTick = std::max(nextTick + interval, std::chrono::steady_clock::now());
+        m_wake.wait_until(lock, nextTick, [this] { return m_stop; });
+    }
+}
\ No newline at end of file
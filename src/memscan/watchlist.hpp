@@ -0,0 +1,83 @@
+#pragma once
+#include "process.hpp"
+#include "scansession.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Summary of one watched address over all samples taken
+ */
+struct WatchStats
+{
+    uintptr_t addr;
+    size_t samples;
+    size_t changes;
+    int64_t min;
+    int64_t max;
+    int64_t last;
+};
+
+/**
+ * \brief Samples a set of addresses at a fixed frequency from a background thread.
+ *
+ * Addresses are grouped into spans of the pages they lie on, so every sample is one Process::readBatch with one
+ * request per page no matter how many addresses share it. The last historySize samples are kept in a ring buffer
+ * with one row per sample, and change count, min and max of every address are updated as samples arrive.
+ *
+ * Values are integers of the session's data size, or the bit pattern of a float/double if isFloat is set. min and
+ * max compare them as such, asDouble() turns them back into floating point.
+ * \param session Scan session, shared with the Scanner
+ * \param addrs Addresses to watch
+ * \param isFloat Values are float/double instead of integers
+ * \param historySize Number of samples kept per address
+ */
+class WatchList
+{
+    public:
+        WatchList(std::shared_ptr<ScanSession> session, const std::vector<uintptr_t>& addrs, bool isFloat,
+                  size_t historySize);
+        ~WatchList();
+
+        WatchList(const WatchList&) = delete;
+        WatchList& operator=(const WatchList&) = delete;
+
+        void start(std::chrono::microseconds interval);
+        void stop();
+
+        std::vector<WatchStats> stats() const;
+        std::vector<int64_t> history(size_t index) const;
+        double asDouble(int64_t value) const;
+
+        const std::vector<uintptr_t>& addrs()   const { return m_addrs; }
+        const bool&                   isFloat() const { return m_isFloat; }
+
+    private:
+        std::shared_ptr<ScanSession> m_session;
+        std::vector<uintptr_t> m_addrs;
+        bool m_isFloat;
+        size_t m_historySize;
+        std::vector<ReadRequest> m_spans;
+        std::vector<char> m_current;
+        // offset of every address in m_current
+        std::vector<size_t> m_offsets;
+        std::vector<int64_t> m_history;
+        std::vector<WatchStats> m_stats;
+        size_t m_sampleCount;
+        bool m_stop;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::thread m_thread;
+
+        void buildSpans();
+        void sampleLoop(std::chrono::microseconds interval);
+        void addSample();
+        bool less(int64_t a, int64_t b) const;
+
+        const static inline size_t pageSize = 4096;
+};
\ No newline at end of file